@@ -1,72 +1,338 @@
-#include<iostream>
 #include<vector>
-#include<queue>
+#include<cstdio>
+#include<algorithm>
+#include<cstdint>
+#include<deque>
+#include<mutex>
+#include<thread>
+#include<atomic>
+#include<functional>
+#include<condition_variable>
+#include<memory>
+#include<string>
+#include<string_view>
+#include<map>
+#include<set>
+#include<random>
+#include<chrono>
+#include<stdexcept>
+
+#include "FrozenSet.h"
+#include "FastIO.h"
+#include "TreeStats.h"
+#include "OpStream.h"
 
 using namespace std;
 
-struct Node {
-    int key;
-    int height;
-    Node *left, *right;
+// Mapped value of a node. An AVL without a Value (a plain ordered set)
+// gets the empty specialisation, which costs no space in the node.
+template <class Value>
+struct Payload {
+    Value value;
+
+    Payload() : value() {}
+    template <class... Args>
+    explicit Payload(Args&&... args) : value(forward<Args>(args)...) {}
+};
+
+template <>
+struct Payload<void> {};
+
+// Nodes refer to each other by 32-bit pool index; 0 plays the role of
+// nullptr. Subtree size (for rank/select) and height share one word, so
+// for an int set key + two links + size/height pack into 16 bytes. A
+// single tree therefore holds at most 2^26 - 1 keys; NodePool enforces it
+// so a size can never wrap.
+template <class Key, class Value = void>
+struct Node : Payload<Value> {
+    static const uint32_t MAX_SIZE = (1u << 26) - 1;
 
-    Node(int k) : key(k), height(1), left(nullptr), right(nullptr) {}
+    Key key;
+    uint32_t left, right;
+    uint32_t size : 26;
+    uint32_t height : 6;
+
+    Node() : key(), left(0), right(0), size(1), height(1) {}
+
+    template <class K, class... Args>
+    explicit Node(piecewise_construct_t, K&& k, Args&&... args)
+        : Payload<Value>(forward<Args>(args)...), key(forward<K>(k)),
+          left(0), right(0), size(1), height(1) {}
 };
+static_assert(sizeof(Node<int>) <= 16, "AVL node should stay within 16 bytes");
 
+// Slab of nodes with an intrusive free list threaded through `left`.
+// Slot 0 is a permanent sentinel of height and size 0, so children never
+// need a null check before either is read. Nodes live in a vector that
+// may move them when it grows, which is why everything holds indices.
+template <class Key, class Value, class Allocator>
+class NodePool {
+private:
+    typedef Node<Key, Value> N;
+    vector<N, typename allocator_traits<Allocator>::template rebind_alloc<N>> nodes;
+    uint32_t freeList = 0;
+
+    // Slots in use or on the free list bound every subtree size, so
+    // refusing to grow past MAX_SIZE of them keeps sizes from wrapping.
+    void checkGrow() const {
+        if (nodes.size() > N::MAX_SIZE) throw length_error("AVL tree is full (2^26 - 1 keys)");
+    }
+
+public:
+    NodePool() { clear(); }
+
+    N& operator[](uint32_t i) { return nodes[i]; }
+    const N& operator[](uint32_t i) const { return nodes[i]; }
+
+    // builds a node from the key and the value's constructor arguments
+    template <class... Args>
+    uint32_t alloc(Args&&... args) {
+        if (freeList) {
+            uint32_t i = freeList;
+            freeList = nodes[i].left;
+            nodes[i] = N(piecewise_construct, forward<Args>(args)...);
+            return i;
+        }
+        checkGrow();
+        nodes.emplace_back(piecewise_construct, forward<Args>(args)...);
+        return (uint32_t)nodes.size() - 1;
+    }
+
+    // Takes over another pool's node, copying or moving its key and
+    // value; links, size and height are left for the caller to set.
+    template <class Src>
+    uint32_t adopt(Src&& n) {
+        uint32_t i;
+        if (freeList) {
+            i = freeList;
+            freeList = nodes[i].left;
+            nodes[i] = forward<Src>(n);
+        } else {
+            checkGrow();
+            nodes.push_back(forward<Src>(n));
+            i = (uint32_t)nodes.size() - 1;
+        }
+        return i;
+    }
+
+    void release(uint32_t i) {
+        // give back whatever a string key or a value holds on to
+        if (!is_trivially_destructible<N>::value) nodes[i] = N();
+        nodes[i].left = freeList;
+        freeList = i;
+    }
+
+    void reserve(size_t n) { nodes.reserve(n + 1); }
+
+    // drops every node at once and returns the memory
+    void clear() {
+        decltype(nodes)().swap(nodes);
+        nodes.emplace_back();
+        nodes[0].size = 0;
+        nodes[0].height = 0;
+        freeList = 0;
+    }
+};
+
+// Small work-stealing fork-join pool. Every worker owns a deque and
+// pushes/pops its own forks at the back while idle workers steal from
+// the front. A thread waiting on a join keeps running queued tasks rather
+// than blocking, so nested fork/join cannot deadlock. Threads outside the
+// pool share one extra deque.
+class ForkJoinPool {
+private:
+    struct Task {
+        function<void()> fn;
+        atomic<bool> done{false};
+    };
+
+    struct Queue {
+        mutex m;
+        deque<Task*> tasks;
+    };
+
+    vector<unique_ptr<Queue>> queues;   // one per worker, then the shared one
+    vector<thread> workers;
+    mutex idleLock;
+    condition_variable idle;
+    atomic<int> pending{0};
+    bool stopping = false;
+
+    static int& self() {
+        static thread_local int id = -1;
+        return id;
+    }
+
+    int myQueue() const {
+        return self() >= 0 ? self() : (int)workers.size();
+    }
+
+    Task* take(int me) {
+        int n = (int)queues.size();
+        for (int k = 0; k < n; k++) {
+            int v = (me + k) % n;
+            Queue& q = *queues[v];
+            lock_guard<mutex> g(q.m);
+            if (q.tasks.empty()) continue;
+            Task* t;
+            if (v == me) { t = q.tasks.back(); q.tasks.pop_back(); }
+            else { t = q.tasks.front(); q.tasks.pop_front(); }
+            pending--;
+            return t;
+        }
+        return nullptr;
+    }
+
+    bool runOne(int me) {
+        Task* t = take(me);
+        if (!t) return false;
+        t->fn();
+        t->done.store(true, memory_order_release);
+        return true;
+    }
+
+    void workerLoop(int me) {
+        self() = me;
+        while (true) {
+            if (runOne(me)) continue;
+            unique_lock<mutex> g(idleLock);
+            idle.wait(g, [&] { return stopping || pending > 0; });
+            if (stopping) return;
+        }
+    }
+
+public:
+    explicit ForkJoinPool(unsigned threads) {
+        for (unsigned i = 0; i <= threads; i++) queues.emplace_back(new Queue);
+        for (unsigned i = 0; i < threads; i++)
+            workers.emplace_back([this, i] { workerLoop((int)i); });
+    }
+
+    ~ForkJoinPool() {
+        {
+            lock_guard<mutex> g(idleLock);
+            stopping = true;
+        }
+        idle.notify_all();
+        for (thread& w : workers) w.join();
+    }
+
+    // process-wide pool with one worker per extra hardware thread
+    static ForkJoinPool& shared() {
+        static ForkJoinPool pool(max(1u, thread::hardware_concurrency()) - 1);
+        return pool;
+    }
+
+    // Runs f and g, possibly in parallel, and returns when both are done.
+    template <class F, class G>
+    void invoke(F&& f, G&& g) {
+        if (workers.empty()) {
+            f();
+            g();
+            return;
+        }
+        Task t;
+        t.fn = g;
+        int me = myQueue();
+        {
+            lock_guard<mutex> lk(queues[me]->m);
+            queues[me]->tasks.push_back(&t);
+        }
+        {
+            lock_guard<mutex> lk(idleLock);
+            pending++;
+        }
+        idle.notify_one();
+        f();
+        while (!t.done.load(memory_order_acquire))
+            if (!runOne(me)) this_thread::yield();
+    }
+};
+
+// Ordered map from Key to Value under Compare, or an ordered set when
+// Value is void. Allocator is rebound to the node type and backs the
+// node pool. Lookups taking any K are offered only when Compare is
+// transparent (e.g. less<>), as with std::map. Pointers handed out by
+// find() and try_emplace() stay valid until the next insertion.
+template <class Key = int, class Value = void, class Compare = less<Key>, class Allocator = allocator<Key>>
 class AVL {
 private:
-    Node* root = nullptr;
+    // AVL height is below 1.45 * log2(n + 2), so 64 levels covers any
+    // tree that fits in memory
+    static const int MAX_DEPTH = 64;
+
+    typedef Node<Key, Value> NodeT;
+    typedef typename conditional<is_void<Value>::value, const Key, Value>::type Mapped;
+
+    NodePool<Key, Value, Allocator> pool;
+    uint32_t root = 0;
+    size_t count = 0;
+    Compare comp;
 
-    int h(Node* n) { return n ? n->height : 0; }
+    // Finger: the root-to-node path of the last insert or failed insert.
+    // Levels [0, fingerTop) are exact, and (fingerLo, fingerHi) is the
+    // open key range the deepest of them covers, as node indices with 0
+    // for unbounded. Anything that restructures the tree other than
+    // place() drops the finger.
+    uint32_t fpath[MAX_DEPTH];
+    bool fdir[MAX_DEPTH];
+    int fingerTop = 0;
+    uint32_t fingerLo = 0, fingerHi = 0;
 
-    int balance(Node* n) { return n ? h(n->left) - h(n->right) : 0; }
+    int h(uint32_t n) const { return pool[n].height; }
 
-    void update(Node* n) {
-        if (!n) return;
-        n->height = max(h(n->left), h(n->right)) + 1;
+    int balance(uint32_t n) const { return h(pool[n].left) - h(pool[n].right); }
+
+    void update(uint32_t n) {
+        NodeT& x = pool[n];
+        x.height = max(h(x.left), h(x.right)) + 1;
+        x.size = pool[x.left].size + pool[x.right].size + 1;
     }
 
-    Node* rightRotate(Node* y) {
-        Node* x = y->left;
-        Node* q = x->right;
+    uint32_t rightRotate(uint32_t y) {
+        uint32_t x = pool[y].left;
+        uint32_t q = pool[x].right;
 
-        x->right = y;
-        y->left = q;
+        pool[x].right = y;
+        pool[y].left = q;
 
         update(y);
         update(x);
         return x;
     }
 
-    Node* leftRotate(Node* x) {
-        Node* y = x->right;
-        Node* q = y->left;
+    uint32_t leftRotate(uint32_t x) {
+        uint32_t y = pool[x].right;
+        uint32_t q = pool[y].left;
 
-        y->left = x;
-        x->right = q;
+        pool[y].left = x;
+        pool[x].right = q;
 
         update(x);
         update(y);
         return y;
     }
 
-Node* rebalance(Node* node) {
+uint32_t rebalance(uint32_t node) {
     update(node);
     int bf = balance(node);
 
     if (bf > 1) {
-        if (balance(node->left) < 0) {
-            node->left->right = rightRotate(node->left->right);
-            node->left = leftRotate(node->left);
-            return rightRotate(node);
+        if (balance(pool[node].left) < 0) {
+            TREE_STAT(AVL_LR);
+            pool[node].left = leftRotate(pool[node].left);
+        } else {
+            TREE_STAT(AVL_LL);
         }
         return rightRotate(node);
     }
 
     if (bf < -1) {
-        if (balance(node->right) > 0) {
-            node->right->left = leftRotate(node->right->left);
-            node->right = rightRotate(node->right);
-            return leftRotate(node);
+        if (balance(pool[node].right) > 0) {
+            TREE_STAT(AVL_RL);
+            pool[node].right = rightRotate(pool[node].right);
+        } else {
+            TREE_STAT(AVL_RR);
         }
         return leftRotate(node);
     }
@@ -74,133 +340,1169 @@ Node* rebalance(Node* node) {
     return node;
 }
 
+    uint32_t& child(uint32_t n, bool right) {
+        return right ? pool[n].right : pool[n].left;
+    }
+
+    // Equivalence under comp. For arithmetic keys under plain less it is
+    // spelled ==, which GCC needs to keep the child select in a descent
+    // branch-free (the two-compare form costs about 2x on lookups).
+    template <class A, class B>
+    bool same(const A& a, const B& b) const {
+        if constexpr (is_arithmetic<Key>::value &&
+                      (is_same<Compare, less<Key>>::value || is_same<Compare, less<>>::value))
+            return a == b;
+        else
+            return !comp(a, b) && !comp(b, a);
+    }
+
+    Mapped* mapped(uint32_t n) {
+        if constexpr (is_void<Value>::value) return &pool[n].key;
+        else return &pool[n].value;
+    }
+
+    // Walks back up the recorded path, rebalancing each subtree in place.
+    // Once a subtree comes out with the height it had before the update,
+    // no rotation can happen above it, and the remaining ancestors only
+    // need their size moved by delta (+1 insert, -1 delete). A subtree
+    // root replaced by a rotation is written back into path; the return
+    // value is the highest such level (top if there was none), above and
+    // at which path still describes the tree.
+    int retrace(uint32_t* path, const bool* dir, int top, int delta) {
+        int exact = top;
+        while (top > 0) {
+            uint32_t n = path[--top];
+            int old = h(n);
+            uint32_t sub = rebalance(n);
+            if (sub != n) {
+                path[top] = sub;
+                exact = top;
+            }
+            if (top == 0) root = sub;
+            else child(path[top - 1], dir[top - 1]) = sub;
+            if (h(sub) == old) break;
+            TREE_STAT(AVL_HEIGHT_CHANGES);
+        }
+        while (top > 0) pool[path[--top]].size += delta;
+        return exact;
+    }
+
+    // The deepest finger level whose subtree's key range holds key, with
+    // that range stored in bound as place() keeps it. Key lies past the
+    // deepest range on one known side, and going up a level's range widens
+    // only on that side, at the ancestors the path left towards it. Those
+    // ancestors' keys are sorted along the path, so the climb gallops up
+    // through them and then bisects: a key next to the finger costs a
+    // comparison or two, and an unrelated one O(log depth) instead of a
+    // walk up to the root.
+    template <class K>
+    int resume(const K& key, uint32_t* bound) const {
+        int level = fingerTop - 1;
+        bound[1] = fingerLo;
+        bound[0] = fingerHi;
+        bool side;
+        if (fingerLo && !comp(pool[fingerLo].key, key)) side = true;
+        else if (fingerHi && !comp(key, pool[fingerHi].key)) side = false;
+        else return level;
 
-    bool contains(Node* node, int key) {
+        // at[0..n): levels whose node bounds the range on that side, root
+        // first; at[n - 1] gives the bound key already fell outside of
+        int at[MAX_DEPTH], n = 0;
+        for (int j = 0; j < level; j++) {
+            at[n] = j;
+            n += fdir[j] == side;
+        }
+        auto admits = [&](int i) {
+            const Key& b = pool[fpath[at[i]]].key;
+            return side ? comp(b, key) : comp(key, b);
+        };
+        int lo = -1, hi = n - 1;   // at[lo] admits key, at[hi] does not
+        for (int step = 1; hi - step >= 0; step *= 2) {
+            if (admits(hi - step)) {
+                lo = hi - step;
+                break;
+            }
+            hi -= step;
+        }
+        while (hi - lo > 1) {
+            int mid = (lo + hi) / 2;
+            if (admits(mid)) lo = mid;
+            else hi = mid;
+        }
+        level = at[hi];
+        bound[side] = lo < 0 ? 0 : fpath[at[lo]];
+        bound[!side] = 0;
+        for (int j = level - 1; j >= 0; j--) {
+            if (fdir[j] != side) {
+                bound[!side] = fpath[j];
+                break;
+            }
+        }
+        return level;
+    }
+
+    template <class K>
+    uint32_t locate(const K& key) const {
+        TreePath probe;
+        uint32_t node = root;
         while (node) {
-            if (key == node->key) return true;
-            node = (key < node->key) ? node->left : node->right;
+            probe.step();
+            const NodeT& cur = pool[node];
+            if (same(key, cur.key)) return node;
+            node = comp(key, cur.key) ? cur.left : cur.right;
+        }
+        return 0;
+    }
+
+    // Both updates descend once, remembering every node (and the side
+    // taken) on the way down, then rebalance bottom-up with retrace().
+    // Indices rather than link pointers are recorded because alloc() may
+    // move the pool.
+    //
+    // place() returns the node holding key and false, or hangs the node
+    // returned by make() where key belongs and returns it and true; make()
+    // runs only once the key is known to be absent. It records its path
+    // in the finger, and starts from the deepest finger level whose range
+    // holds key instead of the root, so an increasing, decreasing or
+    // clustered run of keys costs O(1) comparisons per insert.
+    template <class K, class Make>
+    pair<uint32_t, bool> place(const K& key, Make make) {
+        int top = 0;
+        uint32_t cur = root;
+        // bound[1] / bound[0]: nearest ancestor below / above key so far;
+        // indexing by the side taken keeps the descent free of a branch
+        // the CPU could only guess at for random keys
+        uint32_t bound[2] = {0, 0};
+        if (fingerTop) {
+            top = resume(key, bound);
+            cur = fpath[top];
+        }
+        while (cur) {
+            const NodeT& n = pool[cur];
+            fpath[top] = cur;
+            if (same(key, n.key)) {
+                fingerTop = top + 1;
+                fingerLo = bound[1];
+                fingerHi = bound[0];
+                return {cur, false};
+            }
+            bool right = comp(n.key, key);
+            fdir[top++] = right;
+            bound[right] = cur;
+            cur = right ? n.right : n.left;
+        }
+        uint32_t fresh = make();
+        count++;
+        if (top == 0) root = fresh;
+        else child(fpath[top - 1], fdir[top - 1]) = fresh;
+        fpath[top] = fresh;
+        int exact = retrace(fpath, fdir, top, +1);
+        if (exact < top) {
+            // a rotation replaced everything below level exact; its range
+            // is bounded by the nearest ancestors on either side
+            bound[0] = bound[1] = 0;
+            bool seen[2] = {false, false};
+            for (int i = exact - 1; i >= 0 && !(seen[0] && seen[1]); i--) {
+                if (!seen[fdir[i]]) {
+                    bound[fdir[i]] = fpath[i];
+                    seen[fdir[i]] = true;
+                }
+            }
+        }
+        fingerTop = exact + 1;
+        fingerLo = bound[1];
+        fingerHi = bound[0];
+        return {fresh, true};
+    }
+
+    template <class K>
+    bool remove(const K& key) {
+        uint32_t path[MAX_DEPTH];
+        bool dir[MAX_DEPTH];
+        int top = 0;
+        uint32_t cur = root;
+        while (cur) {
+            const NodeT& n = pool[cur];
+            if (same(key, n.key)) break;
+            path[top] = cur;
+            dir[top] = comp(n.key, key);
+            cur = dir[top++] ? n.right : n.left;
         }
-        return false;
+        if (!cur) return false;
+        fingerTop = 0;
+
+        uint32_t target = cur;
+        int slot = top;
+        if (pool[cur].left && pool[cur].right) {
+            // Unlink the in-order successor instead and then relink that
+            // node in target's place, so no key or value is copied or moved.
+            path[top] = cur;
+            dir[top++] = true;
+            cur = pool[cur].right;
+            while (pool[cur].left) {
+                path[top] = cur;
+                dir[top++] = false;
+                cur = pool[cur].left;
+            }
+        }
+        uint32_t rest = pool[cur].left ? pool[cur].left : pool[cur].right;
+        if (top == 0) root = rest;
+        else child(path[top - 1], dir[top - 1]) = rest;
+        if (cur != target) {
+            NodeT& s = pool[cur];
+            const NodeT& t = pool[target];
+            s.left = t.left;
+            s.right = t.right;
+            s.size = t.size;
+            s.height = t.height;
+            path[slot] = cur;
+            if (slot == 0) root = cur;
+            else child(path[slot - 1], dir[slot - 1]) = cur;
+        }
+        pool.release(target);
+        count--;
+        retrace(path, dir, top, -1);
+        return true;
     }
 
-    Node* insertRec(Node* node, int key) {
-        if (!node) return new Node(key);
+    // builds a perfectly balanced subtree over keys[lo, hi), allocating in
+    // key order so an in-order walk reads the pool front to back
+    uint32_t build(const Key* keys, size_t lo, size_t hi) {
+        if (lo == hi) return 0;
+        size_t mid = lo + (hi - lo) / 2;
+        uint32_t left = build(keys, lo, mid);
+        uint32_t n = pool.alloc(keys[mid]);
+        uint32_t right = build(keys, mid + 1, hi);
+        pool[n].left = left;
+        pool[n].right = right;
+        update(n);
+        return n;
+    }
+
+    // ---- join-based primitives; every index belongs to this->pool ----
+
+    // Subtrees shorter than this are combined sequentially
+    static const int PAR_HEIGHT = 12;
+
+    // nodes dropped by a set operation, released once it has finished
+    struct Garbage {
+        mutex m;
+        vector<uint32_t> nodes;
 
-        if (key < node->key) node->left = insertRec(node->left, key);
-        else if (key > node->key) node->right = insertRec(node->right, key);
-        return rebalance(node);
+        void add(uint32_t n) {
+            lock_guard<mutex> g(m);
+            nodes.push_back(n);
+        }
+    };
+
+    // l < k < r; k is a detached node that becomes the joining key
+    uint32_t joinRight(uint32_t l, uint32_t k, uint32_t r) {
+        uint32_t c = pool[l].right;
+        if (h(c) <= h(r) + 1) {
+            pool[k].left = c;
+            pool[k].right = r;
+            update(k);
+            pool[l].right = k;
+        } else {
+            pool[l].right = joinRight(c, k, r);
+        }
+        return rebalance(l);
     }
 
-    Node* minNode(Node* node) {
-        while (node && node->left) node = node->left;
-        return node;
+    uint32_t joinLeft(uint32_t l, uint32_t k, uint32_t r) {
+        uint32_t c = pool[r].left;
+        if (h(c) <= h(l) + 1) {
+            pool[k].left = l;
+            pool[k].right = c;
+            update(k);
+            pool[r].left = k;
+        } else {
+            pool[r].left = joinLeft(l, k, c);
+        }
+        return rebalance(r);
     }
 
-    Node* deleteRec(Node* node, int key) {
-        if (!node) return nullptr;
+    uint32_t join(uint32_t l, uint32_t k, uint32_t r) {
+        if (h(l) > h(r) + 1) return joinRight(l, k, r);
+        if (h(r) > h(l) + 1) return joinLeft(l, k, r);
+        pool[k].left = l;
+        pool[k].right = r;
+        update(k);
+        return k;
+    }
 
-        if (key < node->key) {
-            node->left = deleteRec(node->left, key);
-        } else if (key > node->key) {
-            node->right = deleteRec(node->right, key);
+    // Splits t around key into l (< key) and r (> key); the node holding
+    // key, if any, comes back detached in `found`.
+    void split(uint32_t t, const Key& key, uint32_t& l, uint32_t& found, uint32_t& r) {
+        if (!t) {
+            l = found = r = 0;
+            return;
+        }
+        uint32_t tl = pool[t].left, tr = pool[t].right;
+        if (comp(key, pool[t].key)) {
+            split(tl, key, l, found, r);
+            r = join(r, t, tr);
+        } else if (comp(pool[t].key, key)) {
+            split(tr, key, l, found, r);
+            l = join(tl, t, l);
         } else {
-            if (!node->left || !node->right) {
-                Node* child = node->left ? node->left : node->right;
-                delete node;
-                return child; 
+            l = tl;
+            found = t;
+            r = tr;
+        }
+    }
+
+    // detaches the largest node of a non-empty t
+    uint32_t splitLast(uint32_t t, uint32_t& last) {
+        uint32_t tl = pool[t].left, tr = pool[t].right;
+        if (!tr) {
+            last = t;
+            return tl;
+        }
+        uint32_t rest = splitLast(tr, last);
+        return join(tl, t, rest);
+    }
+
+    uint32_t join2(uint32_t l, uint32_t r) {
+        if (!l) return r;
+        uint32_t k;
+        uint32_t rest = splitLast(l, k);
+        return join(rest, k, r);
+    }
+
+    void collect(uint32_t t, vector<uint32_t>& out) const {
+        if (!t) return;
+        collect(pool[t].left, out);
+        out.push_back(t);
+        collect(pool[t].right, out);
+    }
+
+    void dropTree(uint32_t t, Garbage& g) {
+        if (!t) return;
+        dropTree(pool[t].left, g);
+        dropTree(pool[t].right, g);
+        g.add(t);
+    }
+
+    template <class F, class G>
+    void fork(bool big, F&& f, G&& g) {
+        if (big) ForkJoinPool::shared().invoke(f, g);
+        else { f(); g(); }
+    }
+
+    uint32_t unite(uint32_t a, uint32_t b, Garbage& g) {
+        if (!a) return b;
+        if (!b) return a;
+        uint32_t al = pool[a].left, ar = pool[a].right;
+        uint32_t bl, dup, br;
+        split(b, pool[a].key, bl, dup, br);
+        if (dup) g.add(dup);
+        uint32_t l, r;
+        fork(h(a) >= PAR_HEIGHT,
+             [&] { l = unite(al, bl, g); },
+             [&] { r = unite(ar, br, g); });
+        return join(l, a, r);
+    }
+
+    uint32_t intersect(uint32_t a, uint32_t b, Garbage& g) {
+        if (!a || !b) {
+            dropTree(a, g);
+            dropTree(b, g);
+            return 0;
+        }
+        uint32_t al = pool[a].left, ar = pool[a].right;
+        uint32_t bl, dup, br;
+        split(b, pool[a].key, bl, dup, br);
+        uint32_t l, r;
+        fork(h(a) >= PAR_HEIGHT,
+             [&] { l = intersect(al, bl, g); },
+             [&] { r = intersect(ar, br, g); });
+        if (dup) {
+            g.add(dup);
+            return join(l, a, r);
+        }
+        g.add(a);
+        return join2(l, r);
+    }
+
+    // a minus b
+    uint32_t subtract(uint32_t a, uint32_t b, Garbage& g) {
+        if (!a || !b) {
+            dropTree(b, g);
+            return a;
+        }
+        uint32_t bl = pool[b].left, br = pool[b].right;
+        uint32_t al, dup, ar;
+        split(a, pool[b].key, al, dup, ar);
+        if (dup) g.add(dup);
+        g.add(b);
+        uint32_t l, r;
+        fork(h(b) >= PAR_HEIGHT,
+             [&] { l = subtract(al, bl, g); },
+             [&] { r = subtract(ar, br, g); });
+        return join2(l, r);
+    }
+
+    // Copies another tree's shape into this pool and returns its root.
+    // A non-const source is being consumed, so its keys and values are
+    // moved rather than copied.
+    template <class Src>
+    uint32_t import(Src& other, uint32_t t) {
+        if (!t) return 0;
+        uint32_t l = import(other, other.pool[t].left);
+        uint32_t n;
+        if constexpr (is_const<Src>::value) n = pool.adopt(other.pool[t]);
+        else n = pool.adopt(move(other.pool[t]));
+        uint32_t r = import(other, other.pool[t].right);
+        pool[n].left = l;
+        pool[n].right = r;
+        return n;
+    }
+
+    template <class Op>
+    void setOp(const AVL& other, Op op) {
+        pool.reserve(count + other.count);
+        uint32_t b = import(other, other.root);
+        Garbage g;
+        fingerTop = 0;
+        root = op(root, b, g);
+        count += other.count;
+        count -= g.nodes.size();
+        for (uint32_t n : g.nodes) pool.release(n);
+    }
+
+
+public:
+    AVL() {}
+    explicit AVL(const Compare& c) : comp(c) {}
+
+    bool contains(const Key& key) const { return locate(key) != 0; }
+
+    template <class K, class C = Compare, class = typename C::is_transparent>
+    bool contains(const K& key) const { return locate(key) != 0; }
+
+    // the value stored under key (the stored key for a set), or nullptr
+    Mapped* find(const Key& key) {
+        uint32_t n = locate(key);
+        return n ? mapped(n) : nullptr;
+    }
+
+    template <class K, class C = Compare, class = typename C::is_transparent>
+    Mapped* find(const K& key) {
+        uint32_t n = locate(key);
+        return n ? mapped(n) : nullptr;
+    }
+
+    const Mapped* find(const Key& key) const { return const_cast<AVL*>(this)->find(key); }
+
+    template <class K, class C = Compare, class = typename C::is_transparent>
+    const Mapped* find(const K& key) const { return const_cast<AVL*>(this)->find(key); }
+
+    bool insertKey(const Key& key) {
+        return place(key, [&] { return pool.alloc(key); }).second;
+    }
+
+    // Inserts key with a Value built from args unless key is present; args
+    // are left untouched in that case. Returns the stored value and
+    // whether it is new.
+    template <class... Args>
+    pair<Mapped*, bool> try_emplace(const Key& key, Args&&... args) {
+        auto p = place(key, [&] { return pool.alloc(key, forward<Args>(args)...); });
+        return {mapped(p.first), p.second};
+    }
+
+    template <class... Args>
+    pair<Mapped*, bool> try_emplace(Key&& key, Args&&... args) {
+        auto p = place(key, [&] { return pool.alloc(move(key), forward<Args>(args)...); });
+        return {mapped(p.first), p.second};
+    }
+
+    // Builds the key from the first argument and the value from the rest,
+    // then inserts them unless the key is present.
+    template <class... Args>
+    pair<Mapped*, bool> emplace(Args&&... args) {
+        NodeT n(piecewise_construct, forward<Args>(args)...);
+        auto p = place(n.key, [&] { return pool.adopt(move(n)); });
+        return {mapped(p.first), p.second};
+    }
+
+    bool deleteKey(const Key& key) { return remove(key); }
+
+    template <class K, class C = Compare, class = typename C::is_transparent>
+    bool deleteKey(const K& key) { return remove(key); }
+
+    void clear() {
+        pool.clear();
+        root = 0;
+        count = 0;
+        fingerTop = 0;
+    }
+
+    size_t size() const { return count; }
+
+    // number of keys < key
+    int rank(const Key& key) const {
+        int res = 0;
+        uint32_t n = root;
+        while (n) {
+            const NodeT& cur = pool[n];
+            if (!comp(cur.key, key)) {
+                n = cur.left;
+            } else {
+                res += pool[cur.left].size + 1;
+                n = cur.right;
+            }
+        }
+        return res;
+    }
+
+    // number of keys in [lo, hi)
+    int countRange(const Key& lo, const Key& hi) const {
+        return comp(lo, hi) ? rank(hi) - rank(lo) : 0;
+    }
+
+    // k-th smallest key, 0-based; false if k is out of range
+    bool select(size_t k, Key& key) const {
+        if (k >= count) return false;
+        uint32_t n = root;
+        while (true) {
+            const NodeT& cur = pool[n];
+            size_t ls = pool[cur.left].size;
+            if (k < ls) {
+                n = cur.left;
+            } else if (k == ls) {
+                key = cur.key;
+                return true;
+            } else {
+                k -= ls + 1;
+                n = cur.right;
+            }
+        }
+    }
+
+    // Concatenates L, key, R where every key of L < key < every key of R;
+    // for a map the joining key's value is built from args. R's nodes are
+    // moved into L's pool; the combine itself is O(|h(L) - h(R)|).
+    template <class... Args>
+    static AVL join(AVL&& L, Key key, AVL&& R, Args&&... args) {
+        AVL t = move(L);
+        L.clear();
+        t.pool.reserve(t.count + R.count + 1);
+        uint32_t r = t.import(R, R.root);
+        uint32_t k = t.pool.alloc(move(key), forward<Args>(args)...);
+        t.fingerTop = 0;
+        t.root = t.join(t.root, k, r);
+        t.count += R.count + 1;
+        R.clear();
+        return t;
+    }
+
+    // Leaves the keys < key in this tree and moves the keys > key into
+    // `greater` (into its pool). Returns whether key was present.
+    bool split(const Key& key, AVL& greater) {
+        uint32_t l, found, r;
+        split(root, key, l, found, r);
+        vector<uint32_t> moved;
+        collect(r, moved);
+        greater.clear();
+        greater.root = greater.import(*this, r);
+        greater.count = moved.size();
+        for (uint32_t n : moved) pool.release(n);
+        if (found) pool.release(found);
+        root = l;
+        fingerTop = 0;
+        count -= greater.count + (found ? 1 : 0);
+        return found != 0;
+    }
+
+    // Set operations in O(m log(n/m + 1)) work, the two halves of every
+    // large subproblem running on ForkJoinPool::shared(). For maps, a key
+    // present in both trees keeps this tree's value.
+    void unionWith(const AVL& other) {
+        setOp(other, [this](uint32_t a, uint32_t b, Garbage& g) { return unite(a, b, g); });
+    }
+
+    void intersectWith(const AVL& other) {
+        setOp(other, [this](uint32_t a, uint32_t b, Garbage& g) { return intersect(a, b, g); });
+    }
+
+    void subtract(const AVL& other) {
+        setOp(other, [this](uint32_t a, uint32_t b, Garbage& g) { return subtract(a, b, g); });
+    }
+
+    // Replaces the contents with a perfectly balanced tree in O(n).
+    // `sorted` must be strictly increasing.
+    void bulkLoad(const vector<Key>& sorted) {
+        static_assert(is_void<Value>::value, "bulkLoad() builds sets only");
+        if (sorted.size() > Node<Key, Value>::MAX_SIZE) throw length_error("AVL tree is full (2^26 - 1 keys)");
+        clear();
+        pool.reserve(sorted.size());
+        root = build(sorted.data(), 0, sorted.size());
+        count = sorted.size();
+    }
+
+    // Adds a strictly increasing batch of keys; inserted[i] reports whether
+    // batch[i] was new. A small batch goes through insertKey, a large one
+    // is merged with the in-order key list and the tree rebuilt in
+    // O(n + m), which beats m separate O(log n) inserts once m is a
+    // noticeable fraction of n.
+    size_t mergeBatch(const vector<Key>& batch, vector<bool>& inserted) {
+        static_assert(is_void<Value>::value, "mergeBatch() builds sets only");
+        inserted.assign(batch.size(), false);
+        size_t added = 0;
+        if (batch.size() * 16 < count) {
+            for (size_t i = 0; i < batch.size(); i++)
+                if (insertKey(batch[i])) inserted[i] = true, added++;
+            return added;
+        }
+
+        vector<Key> old;
+        old.reserve(count);
+        Walk w(*this, IN);
+        for (Key key; w.next(key); ) old.push_back(key);
+
+        vector<Key> merged;
+        merged.reserve(old.size() + batch.size());
+        size_t i = 0, j = 0;
+        while (j < batch.size()) {
+            if (i < old.size() && comp(old[i], batch[j])) {
+                merged.push_back(old[i++]);
+            } else if (i < old.size() && !comp(batch[j], old[i])) {
+                merged.push_back(old[i++]);
+                j++;
             } else {
-                Node* succ = minNode(node->right);
-                node->key = succ->key;
-                node->right = deleteRec(node->right, succ->key);
+                merged.push_back(batch[j]);
+                inserted[j++] = true;
+                added++;
+            }
+        }
+        while (i < old.size()) merged.push_back(old[i++]);
+
+        bulkLoad(merged);
+        return added;
+    }
+
+    enum Order { PRE = 1, LEVEL = 2, IN = 3, POST = 4 };
+
+    // Lazy traversal in any Order, or an in-order scan of [lo, hi). Each
+    // one keeps an explicit stack bounded by the tree height, so memory
+    // does not grow with the tree. Level order re-walks the top levels
+    // once per level (iterative deepening), which on a balanced tree adds
+    // only a constant factor. Any update to the tree invalidates a Walk.
+    class Walk {
+    private:
+        friend class AVL;
+
+        const AVL& t;
+        int type;
+        uint32_t stack[2 * MAX_DEPTH];
+        uint8_t depth[2 * MAX_DEPTH];
+        int top = 0;
+        uint32_t cur = 0, last = 0;
+        int level = 0;
+        bool bounded = false;
+        Key hi;
+
+        void push(uint32_t n, int d = 0) {
+            stack[top] = n;
+            depth[top++] = (uint8_t)d;
+        }
+
+        // the next node in order, or 0 at the end
+        uint32_t advance() {
+            const auto& p = t.pool;
+            if (type == PRE) {
+                if (!top) return 0;
+                uint32_t n = stack[--top];
+                if (p[n].right) push(p[n].right);
+                if (p[n].left) push(p[n].left);
+                return n;
+            }
+            if (type == IN) {
+                while (cur) {
+                    push(cur);
+                    cur = p[cur].left;
+                }
+                if (!top) return 0;
+                uint32_t n = stack[--top];
+                if (bounded && !t.comp(p[n].key, hi)) {
+                    top = 0;
+                    return 0;
+                }
+                cur = p[n].right;
+                return n;
             }
+            if (type == POST) {
+                while (true) {
+                    if (cur) {
+                        push(cur);
+                        cur = p[cur].left;
+                        continue;
+                    }
+                    if (!top) return 0;
+                    uint32_t n = stack[top - 1];
+                    if (p[n].right && last != p[n].right) {
+                        cur = p[n].right;
+                        continue;
+                    }
+                    top--;
+                    last = n;
+                    return n;
+                }
+            }
+            if (type == LEVEL) {
+                while (true) {
+                    while (top) {
+                        top--;
+                        uint32_t n = stack[top];
+                        int d = depth[top];
+                        if (d == level) return n;
+                        if (p[n].right) push(p[n].right, d + 1);
+                        if (p[n].left) push(p[n].left, d + 1);
+                    }
+                    if (++level >= t.h(t.root)) return 0;
+                    push(t.root);
+                }
+            }
+            return 0;
+        }
+
+    public:
+        Walk(const AVL& tree, int order) : t(tree), type(order), hi() {
+            if (!t.root) return;
+            if (type == PRE || type == LEVEL) push(t.root);
+            else if (type == IN || type == POST) cur = t.root;
+        }
+
+        Walk(const AVL& tree, const Key& lo, const Key& hi) : t(tree), type(IN), bounded(true), hi(hi) {
+            uint32_t n = t.root;
+            while (n) {
+                if (!t.comp(t.pool[n].key, lo)) {
+                    push(n);
+                    n = t.pool[n].left;
+                } else {
+                    n = t.pool[n].right;
+                }
+            }
+        }
+
+        bool next(Key& key) {
+            uint32_t n = advance();
+            if (!n) return false;
+            key = t.pool[n].key;
+            return true;
         }
-        return rebalance(node);
+    };
+
+    // calls f(key) for a set, f(key, value) for a map, in key order
+    template <class F>
+    void forEach(F f) {
+        Walk w(*this, IN);
+        for (uint32_t n; (n = w.advance()); ) {
+            if constexpr (is_void<Value>::value) f(pool[n].key);
+            else f(pool[n].key, pool[n].value);
+        }
+    }
+
+    template <class F>
+    void forEach(F f) const {
+        Walk w(*this, IN);
+        for (uint32_t n; (n = w.advance()); ) {
+            if constexpr (is_void<Value>::value) f(pool[n].key);
+            else f(pool[n].key, pool[n].value);
+        }
+    }
+
+    // streams the keys in the given order, space separated, into out
+    template <class Sink>
+    void traverse(int type, Sink& out) const {
+        Walk w(*this, type);
+        bool first = true;
+        for (uint32_t n; (n = w.advance()); first = false) {
+            if (!first) out << ' ';
+            out << pool[n].key;
+        }
+    }
+
+    vector<Key> traverse(int type) const {
+        vector<Key> out;
+        Walk w(*this, type);
+        for (uint32_t n; (n = w.advance()); ) out.push_back(pool[n].key);
+        return out;
+    }
+
+    // read-only Eytzinger copy of the current keys, O(n); int keys only
+    FrozenSet freeze() const { return FrozenSet(traverse(IN)); }
+
+};
+
+// Persistent AVL: nodes are immutable once published, and every update
+// path-copies the O(log n) nodes from the root down to the change while
+// sharing all untouched subtrees with the previous version. Readers take
+// a Version (a counted reference to one root) and can keep using it for
+// as long as they like while the writer moves on; a version's nodes are
+// reclaimed by reference counting once no Version or newer root shares
+// them. Updates are serialized among themselves.
+class PersistentAVL {
+private:
+    struct PNode;
+    typedef shared_ptr<const PNode> Ptr;
+
+    struct PNode {
+        int key;
+        int height;
+        int size;
+        Ptr left, right;
+
+        PNode(int k, Ptr l, Ptr r)
+            : key(k), height(max(h(l), h(r)) + 1), size(sz(l) + sz(r) + 1),
+              left(move(l)), right(move(r)) {}
+    };
+
+    static int h(const Ptr& n) { return n ? n->height : 0; }
+    static int sz(const Ptr& n) { return n ? n->size : 0; }
+
+    static Ptr mk(int key, Ptr l, Ptr r) {
+        return make_shared<const PNode>(key, move(l), move(r));
     }
 
-    void preorder(Node* node, vector<int>& out) {
-        if (!node) return;
-        out.push_back(node->key);
-        preorder(node->left, out);
-        preorder(node->right, out);
+    // new node for key over l and r, rotating (by copying) if the heights
+    // differ by two
+    static Ptr balanced(int key, Ptr l, Ptr r) {
+        if (h(l) > h(r) + 1) {
+            if (h(l->left) >= h(l->right))
+                return mk(l->key, l->left, mk(key, l->right, move(r)));
+            const Ptr& lr = l->right;
+            return mk(lr->key, mk(l->key, l->left, lr->left), mk(key, lr->right, move(r)));
+        }
+        if (h(r) > h(l) + 1) {
+            if (h(r->right) >= h(r->left))
+                return mk(r->key, mk(key, move(l), r->left), r->right);
+            const Ptr& rl = r->left;
+            return mk(rl->key, mk(key, move(l), rl->left), mk(r->key, rl->right, r->right));
+        }
+        return mk(key, move(l), move(r));
     }
 
-    void inorder(Node* node, vector<int>& out) {
-        if (!node) return;
-        inorder(node->left, out);
-        out.push_back(node->key);
-        inorder(node->right, out);
+    // Both return the root of the new version, or node itself when
+    // nothing changed, so an unchanged path is never copied.
+    static Ptr insertRec(const Ptr& node, int key) {
+        if (!node) return mk(key, nullptr, nullptr);
+        if (key < node->key) {
+            Ptr l = insertRec(node->left, key);
+            return l == node->left ? node : balanced(node->key, l, node->right);
+        }
+        if (key > node->key) {
+            Ptr r = insertRec(node->right, key);
+            return r == node->right ? node : balanced(node->key, node->left, r);
+        }
+        return node;
     }
 
-    void postorder(Node* node, vector<int>& out) {
-        if (!node) return;
-        postorder(node->left, out);
-        postorder(node->right, out);
-        out.push_back(node->key);
+    static Ptr removeMin(const Ptr& node, int& minKey) {
+        if (!node->left) {
+            minKey = node->key;
+            return node->right;
+        }
+        return balanced(node->key, removeMin(node->left, minKey), node->right);
     }
 
-    void levelorder(Node* node, vector<int>& out) {
-        if (!node) return;
-        queue<Node*> q;
-        q.push(node);
-        while (!q.empty()) {
-            Node* cur = q.front(); q.pop();
-            out.push_back(cur->key);
-            if (cur->left) q.push(cur->left);
-            if (cur->right) q.push(cur->right);
+    static Ptr deleteRec(const Ptr& node, int key) {
+        if (!node) return node;
+        if (key < node->key) {
+            Ptr l = deleteRec(node->left, key);
+            return l == node->left ? node : balanced(node->key, l, node->right);
+        }
+        if (key > node->key) {
+            Ptr r = deleteRec(node->right, key);
+            return r == node->right ? node : balanced(node->key, node->left, r);
         }
+        if (!node->left) return node->right;
+        if (!node->right) return node->left;
+        int succ;
+        Ptr r = removeMin(node->right, succ);
+        return balanced(succ, node->left, r);
     }
 
+    Ptr head;
+    mutex writeLock;
 
 public:
+    // One immutable version of the set
+    class Version {
+    private:
+        Ptr root;
+
+        template <class F>
+        static void inorder(const PNode* n, F& f) {
+            if (!n) return;
+            inorder(n->left.get(), f);
+            f(n->key);
+            inorder(n->right.get(), f);
+        }
+
+    public:
+        explicit Version(Ptr r) : root(move(r)) {}
+
+        size_t size() const { return sz(root); }
+
+        bool contains(int key) const {
+            const PNode* n = root.get();
+            while (n) {
+                if (key == n->key) return true;
+                n = (key < n->key) ? n->left.get() : n->right.get();
+            }
+            return false;
+        }
+
+        int rank(int key) const {
+            int res = 0;
+            const PNode* n = root.get();
+            while (n) {
+                if (key <= n->key) {
+                    n = n->left.get();
+                } else {
+                    res += sz(n->left) + 1;
+                    n = n->right.get();
+                }
+            }
+            return res;
+        }
+
+        // calls f(key) for every key in increasing order
+        template <class F>
+        void forEach(F f) const { inorder(root.get(), f); }
+    };
+
+    Version snapshot() const { return Version(atomic_load(&head)); }
+
     bool insertKey(int key) {
-        if (contains(root, key)) return false;
-        root = insertRec(root, key);
+        lock_guard<mutex> g(writeLock);
+        Ptr next = insertRec(head, key);
+        if (next == head) return false;
+        atomic_store(&head, next);
         return true;
     }
 
     bool deleteKey(int key) {
-        if (!contains(root, key)) return false;
-        root = deleteRec(root, key);
+        lock_guard<mutex> g(writeLock);
+        Ptr next = deleteRec(head, key);
+        if (next == head) return false;
+        atomic_store(&head, next);
         return true;
     }
+};
 
-vector<int> traverse(int type) {
-    vector<int> out;
-    if (type == 1) preorder(root, out);
-    else if (type == 2) levelorder(root, out); 
-    else if (type == 3) inorder(root, out);
-    else if (type == 4) postorder(root, out);
-    return out;
+// ---- `AVLToffline --bench`: generic AVL against the standard tree ----
+
+template <class F>
+double nsPerOp(size_t ops, F f) {
+    auto start = chrono::steady_clock::now();
+    f();
+    return chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / ops;
 }
 
-};
+template <class K, class V, class C, class A, class X>
+bool benchLookup(const AVL<K, V, C, A>& t, const X& key) { return t.contains(key); }
 
-int main() {
-    int N;
-    cin >> N;
+template <class M, class X>
+bool benchLookup(const M& m, const X& key) { return m.find(key) != m.end(); }
 
-    cout << N << endl;
+template <class K, class V, class C, class A, class X>
+bool benchErase(AVL<K, V, C, A>& t, const X& key) { return t.deleteKey(key); }
 
-    AVL avl;
+template <class M, class X>
+bool benchErase(M& m, const X& key) { return m.erase(key) > 0; }
+
+// Emplaces keys[i] with value(i), looks up every probe, then erases every
+// key; fills ns with the three per-op times.
+template <class Tree, class Key, class Probe, class MakeValue>
+long timeTree(const vector<Key>& keys, const vector<Probe>& probes, MakeValue value, double* ns) {
+    Tree t;
+    long hits = 0;
+    ns[0] = nsPerOp(keys.size(), [&] {
+        for (size_t i = 0; i < keys.size(); i++) value(t, keys[i], i);
+    });
+    ns[1] = nsPerOp(probes.size(), [&] {
+        for (const Probe& p : probes) hits += benchLookup(t, p);
+    });
+    ns[2] = nsPerOp(keys.size(), [&] {
+        for (const Key& k : keys) hits += benchErase(t, k);
+    });
+    return hits;
+}
+
+template <class Tree, class Std, class Key, class Probe, class MakeValue>
+void benchRow(const char* name, const vector<Key>& keys, const vector<Probe>& probes, MakeValue value) {
+    double mine[3], theirs[3];
+    long a = timeTree<Tree>(keys, probes, value, mine);
+    long b = timeTree<Std>(keys, probes, value, theirs);
+    printf("%-24s", name);
+    for (int k = 0; k < 3; k++) printf("%10.0f%10.0f", mine[k], theirs[k]);
+    printf("%s\n", a == b ? "" : "  MISMATCH");
+}
+
+void evaluateGeneric() {
+    const int N = 1 << 20;
+    mt19937_64 rng(42);
+
+    vector<int> ints(N);
+    for (int& k : ints) k = (int)(rng() % (4 * N));
+    vector<uint64_t> ids(N);
+    for (uint64_t& k : ids) k = rng();
+    vector<string> names(N);
+    for (string& k : names) k = "user:" + to_string(rng() % (4 * N));
+    vector<string_view> views(names.begin(), names.end());
+
+    printf("Generic AVL vs std (ns/op, %d random keys, probes = keys):\n", N);
+    printf("====================================================================================\n");
+    printf("%-24s%20s%20s%20s\n", "", "emplace", "find", "erase");
+    printf("%-24s", "Instantiation");
+    for (int k = 0; k < 3; k++) printf("%10s%10s", "AVL", "std");
+    printf("\n");
+    printf("------------------------------------------------------------------------------------\n");
+
+    benchRow<AVL<int>, set<int>>("int set", ints, ints,
+        [](auto& t, int k, size_t) { t.emplace(k); });
+    benchRow<AVL<uint64_t, string>, map<uint64_t, string>>("u64 -> string", ids, ids,
+        [](auto& t, uint64_t k, size_t i) { t.emplace(k, to_string(i)); });
+    benchRow<AVL<string, unique_ptr<int>, less<>>, map<string, unique_ptr<int>, less<>>>(
+        "string -> unique_ptr", names, views,
+        [](auto& t, const string& k, size_t i) { t.emplace(k, make_unique<int>((int)i)); });
+    printf("====================================================================================\n");
+}
+
+// Inserts shorter than this are not worth sorting into a batch
+const int MIN_BATCH = 64;
+
+// A run of rank queries is answered from a frozen snapshot once it is at
+// least this long and at least 1/8 of the tree size, which pays for the
+// O(n) freeze.
+const int MIN_FROZEN_RUN = 1024;
+
+// Answers the run of inserts ops[lo, hi) with a single mergeBatch. Only
+// the first occurrence of a key inside the run can succeed.
+void insertRun(AVL<>& avl, const vector<pair<int, int>>& ops, int lo, int hi, OutBuf& out) {
+    vector<pair<int, int>> byKey;   // (key, op index)
+    for (int i = lo; i < hi; i++) byKey.push_back({ops[i].second, i});
+    sort(byKey.begin(), byKey.end());
+
+    vector<int> keys, first;
+    for (auto& p : byKey) {
+        if (keys.empty() || keys.back() != p.first) {
+            keys.push_back(p.first);
+            first.push_back(p.second);
+        }
+    }
+
+    vector<bool> inserted;
+    avl.mergeBatch(keys, inserted);
+
+    vector<int> r(hi - lo, 0);
+    for (size_t k = 0; k < keys.size(); k++) r[first[k] - lo] = inserted[k];
+    for (int i = lo; i < hi; i++)
+        out << 1 << " " << ops[i].second << " " << r[i - lo] << '\n';
+}
+
+// `AVLToffline --bench` times the generic map against std::set/map.
+// `--ops FILE` replays a binary op stream (see OpStream.h) instead of
+// reading text from stdin, and `--quiet` drops the output.
+int main(int argc, char* argv[]) {
+    const char* opsPath = nullptr;
+    bool quiet = false;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--bench") {
+            evaluateGeneric();
+            TREE_STATS_DUMP(stderr);
+            return 0;
+        }
+        if (arg == "--ops" && i + 1 < argc) opsPath = argv[++i];
+        else if (arg == "--quiet") quiet = true;
+        else {
+            fprintf(stderr, "unknown argument %s\n"
+                    "usage: %s [--bench | [--ops FILE] [--quiet]]\n",
+                    argv[i], argv[0]);
+            return 1;
+        }
+    }
+
+    OutBuf out;
+    if (quiet) out.mute();
+
+    // The stream is read up front. Batched inserts build a different
+    // (equally valid) shape than one-at-a-time inserts, so they are only
+    // used when no pre/level/post-order traversal can observe the shape.
+    vector<pair<int, int>> ops;
+    if (opsPath) {
+        try {
+            readOps(opsPath, ops);
+        } catch (const exception& e) {
+            fprintf(stderr, "%s\n", e.what());
+            return 1;
+        }
+    } else {
+        InBuf in;
+        int N;
+        in >> N;
+        if (N < 0) N = 0;
+        ops.resize(N);
+        for (auto& op : ops) in >> op.first >> op.second;
+    }
+    int N = (int)ops.size();
+    out << N << '\n';
+
+    bool shapeVisible = false;
+    for (auto& op : ops)
+        if (op.first == 2 && op.second != 3) shapeVisible = true;
+
+    AVL<> avl;
+
+    // end of the last run found too short to batch; runs are only
+    // measured from their first op, so the ops up to here run one by one
+    int runEnd = 0;
 
     for (int i = 0; i < N; i++) {
-        int e, x;
-        cin >> e >> x;
+        int e = ops[i].first, x = ops[i].second;
+
+        if (e == 1 && !shapeVisible && i >= runEnd) {
+            int j = i;
+            while (j < N && ops[j].first == 1) j++;
+            if (j - i >= MIN_BATCH) {
+                insertRun(avl, ops, i, j, out);
+                i = j - 1;
+                continue;
+            }
+            runEnd = j;
+        }
+
+        if (e == 3 && i >= runEnd) {
+            int j = i;
+            while (j < N && ops[j].first == 3) j++;
+            if (j - i >= MIN_FROZEN_RUN && (size_t)(j - i) * 8 >= avl.size()) {
+                FrozenSet frozen = avl.freeze();
+                for (; i < j; i++)
+                    out << 3 << " " << ops[i].second << " " << frozen.countLess(ops[i].second) << '\n';
+                i = j - 1;
+                continue;
+            }
+            runEnd = j;
+        }
 
         if (e == 1) {
             int r = avl.insertKey(x) ? 1 : 0;
-            cout << e << " " << x << " " << r << endl;
+            out << e << " " << x << " " << r << '\n';
         } else if (e == 0) {
             int r = avl.deleteKey(x) ? 1 : 0;
-            cout << e << " " << x << " " << r << endl;
+            out << e << " " << x << " " << r << '\n';
         } else if (e == 2) {
-            vector<int> ans = avl.traverse(x);
-            for (int j = 0; j < (int)ans.size(); j++) {
-                if (j) cout << " ";
-                cout << ans[j];
-            }
-            cout << endl;
+            avl.traverse(x, out);
+            out << '\n';
+        } else if (e == 3) {
+            out << e << " " << x << " " << avl.rank(x) << '\n';
         }
     }
+    out.flush();
+    TREE_STATS_DUMP(stderr);
     return 0;
 }
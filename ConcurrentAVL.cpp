@@ -0,0 +1,804 @@
+#include<iostream>
+#include<vector>
+#include<set>
+#include<atomic>
+#include<mutex>
+#include<thread>
+#include<random>
+#include<chrono>
+#include<iomanip>
+#include<algorithm>
+#include<cstdint>
+#include<cstdlib>
+
+using namespace std;
+
+// Concurrent AVL set after Bronson, Casper, Chafi and Olukotun, "A Practical
+// Concurrent Binary Search Tree" (PPoPP 2010).
+//
+// - contains() takes no locks. Every node carries a version number that a
+//   rotation bumps when it shrinks the node's key range; readers validate
+//   the version of the node they came from before trusting a child link
+//   and retry from there if it moved.
+// - insert/remove lock only the node they attach to or unlink (plus its
+//   parent), and the fixups lock the two or three nodes they rotate.
+// - Removing a node with two children just clears its `present` flag and
+//   leaves it as a routing node; it is spliced out once it is down to one
+//   child.
+// - Balance is relaxed: heights are hints that whoever damages a node
+//   repairs afterwards. As in the original, a rotation that races with a
+//   height repair below it can leave one hint stale until the next update
+//   passes through that node, so the shape is AVL-like rather than
+//   strictly AVL under contention.
+
+// Test-and-test-and-set lock; node locks are only held for a few stores
+class SpinLock {
+private:
+    atomic<bool> held{false};
+
+public:
+    void lock() {
+        while (held.exchange(true, memory_order_acquire))
+            while (held.load(memory_order_relaxed)) this_thread::yield();
+    }
+
+    void unlock() { held.store(false, memory_order_release); }
+};
+
+// Epoch-based reclamation. A thread publishes the global epoch while it is
+// inside a tree operation, and a node unlinked at epoch r is only freed
+// once every thread still inside an operation entered after r.
+class Epochs {
+public:
+    static const int MAX_THREADS = 256;
+
+private:
+    struct alignas(64) Slot {
+        atomic<bool> owned{false};
+        atomic<uint64_t> epoch{0};   // 0: not inside an operation
+    };
+
+    atomic<uint64_t> global{1};
+    Slot slots[MAX_THREADS];
+
+    struct Claim {
+        int id = -1;
+        ~Claim() {
+            if (id >= 0) instance().slots[id].owned = false;
+        }
+    };
+
+    Slot& mine() {
+        static thread_local Claim claim;
+        while (claim.id < 0) {
+            for (int i = 0; i < MAX_THREADS && claim.id < 0; i++) {
+                bool expected = false;
+                if (slots[i].owned.compare_exchange_strong(expected, true)) claim.id = i;
+            }
+            if (claim.id < 0) this_thread::yield();
+        }
+        return slots[claim.id];
+    }
+
+public:
+    static Epochs& instance() {
+        static Epochs e;
+        return e;
+    }
+
+    void enter() {
+        Slot& s = mine();
+        uint64_t e;
+        do {
+            e = global.load();
+            s.epoch.store(e);
+        } while (global.load() != e);
+    }
+
+    void exit() { mine().epoch.store(0); }
+
+    // this thread's slot; no other live thread has the same one
+    int id() { return (int)(&mine() - slots); }
+
+    uint64_t current() const { return global.load(); }
+
+    // moves the epoch on and returns the oldest epoch still in use
+    uint64_t advance() {
+        uint64_t oldest = ++global;
+        for (int i = 0; i < MAX_THREADS; i++) {
+            uint64_t e = slots[i].epoch.load();
+            if (e && e < oldest) oldest = e;
+        }
+        return oldest;
+    }
+};
+
+class ConcurrentAVL {
+private:
+    static const uint64_t UNLINKED = 1;
+    static const uint64_t SHRINKING = 2;
+
+    // results of nodeCondition(); anything else is the corrected height
+    static const int NOTHING_REQUIRED = -1;
+    static const int REBALANCE_REQUIRED = -2;
+    static const int UNLINK_REQUIRED = -3;
+
+    static const int RETRY = 2;
+
+    struct Node {
+        const int key;
+        atomic<int> height;
+        atomic<bool> present;   // false: routing node
+        atomic<uint64_t> version;
+        atomic<Node*> parent, left, right;
+        SpinLock lock;
+
+        Node(int k, bool p, Node* par)
+            : key(k), height(1), present(p), version(0), parent(par), left(nullptr), right(nullptr) {}
+
+        atomic<Node*>& child(int dir) { return dir < 0 ? left : right; }
+    };
+
+    struct Guard {
+        Guard() { Epochs::instance().enter(); }
+        ~Guard() { Epochs::instance().exit(); }
+    };
+
+    // The real root hangs off holder.right, so the root can be rotated and
+    // replaced like any other child.
+    Node holder{0, false, nullptr};
+
+    // One list per epoch slot, so only the thread holding the slot ever
+    // touches it and retiring takes no lock.
+    struct alignas(64) RetireList {
+        vector<Node*> unlinked;                  // by the operation in progress
+        vector<pair<Node*, uint64_t>> retired;   // with the epoch they were retired in
+    };
+
+    RetireList retireLists[Epochs::MAX_THREADS];
+
+    static bool shrinkingOrUnlinked(uint64_t v) { return (v & (UNLINKED | SHRINKING)) != 0; }
+    static uint64_t beginChange(uint64_t v) { return v | SHRINKING; }
+    static uint64_t endChange(uint64_t v) { return (v | UNLINKED | SHRINKING) + 1; }
+
+    static int height(Node* n) { return n ? n->height.load() : 0; }
+
+    static void waitUntilShrinkCompleted(Node* n, uint64_t v) {
+        if (!(v & SHRINKING)) return;
+        while (n->version.load() == v) this_thread::yield();
+    }
+
+    // Called once an update has dropped all its node locks: stamps the
+    // nodes it unlinked and, every 1024 of them, frees the ones no thread
+    // can still be reading.
+    void retire() {
+        Epochs& epochs = Epochs::instance();
+        RetireList& mine = retireLists[epochs.id()];
+        if (mine.unlinked.empty()) return;
+        uint64_t now = epochs.current();
+        for (Node* n : mine.unlinked) mine.retired.push_back({n, now});
+        mine.unlinked.clear();
+        if (mine.retired.size() < 1024) return;
+        uint64_t safe = epochs.advance();
+        size_t kept = 0;
+        for (auto& r : mine.retired) {
+            if (r.second < safe) delete r.first;
+            else mine.retired[kept++] = r;
+        }
+        mine.retired.resize(kept);
+    }
+
+    // ---- reads ----
+
+    int attemptGet(int key, Node* node, int dir, uint64_t nodeV) {
+        while (true) {
+            Node* child = node->child(dir).load();
+            if (!child) return node->version.load() != nodeV ? RETRY : 0;
+            if (key == child->key) return child->present.load();
+
+            uint64_t childV = child->version.load();
+            if (shrinkingOrUnlinked(childV)) {
+                waitUntilShrinkCompleted(child, childV);
+                if (node->version.load() != nodeV) return RETRY;
+            } else if (child != node->child(dir).load()) {
+                if (node->version.load() != nodeV) return RETRY;
+            } else {
+                // the hop node -> child is valid, so node may change freely
+                // from here on
+                if (node->version.load() != nodeV) return RETRY;
+                int r = attemptGet(key, child, key < child->key ? -1 : 1, childV);
+                if (r != RETRY) return r;
+            }
+        }
+    }
+
+    // ---- fixups; the _nl helpers expect the caller to hold the locks ----
+
+    int nodeCondition(Node* node) {
+        Node* nL = node->left.load();
+        Node* nR = node->right.load();
+        if ((!nL || !nR) && !node->present.load()) return UNLINK_REQUIRED;
+
+        int hN = node->height.load();
+        int hL = height(nL), hR = height(nR);
+        int hNRepl = 1 + max(hL, hR);
+        int bal = hL - hR;
+        if (bal < -1 || bal > 1) return REBALANCE_REQUIRED;
+        return hN != hNRepl ? hNRepl : NOTHING_REQUIRED;
+    }
+
+    // Each _nl fixup returns the next node that still needs attention,
+    // or nullptr when the damage has been repaired.
+    Node* fixHeight_nl(Node* node) {
+        int c = nodeCondition(node);
+        if (c == REBALANCE_REQUIRED || c == UNLINK_REQUIRED) return node;
+        if (c == NOTHING_REQUIRED) return nullptr;
+        node->height = c;
+        return node->parent.load();
+    }
+
+    bool attemptUnlink_nl(Node* parent, Node* node) {
+        Node* pL = parent->left.load();
+        Node* pR = parent->right.load();
+        if (pL != node && pR != node) return false;
+
+        Node* l = node->left.load();
+        Node* r = node->right.load();
+        if (l && r) return false;
+
+        Node* splice = l ? l : r;
+        if (pL == node) parent->left = splice;
+        else parent->right = splice;
+        if (splice) splice->parent = parent;
+
+        node->version = UNLINKED;
+        node->present = false;
+        retireLists[Epochs::instance().id()].unlinked.push_back(node);
+        return true;
+    }
+
+    Node* rotateRight_nl(Node* nParent, Node* n, Node* nL, int hR, int hLL, Node* nLR, int hLR) {
+        uint64_t nodeV = n->version.load();
+        Node* nPL = nParent->left.load();
+
+        n->version = beginChange(nodeV);
+
+        n->left = nLR;
+        if (nLR) nLR->parent = n;
+        nL->right = n;
+        n->parent = nL;
+        if (nPL == n) nParent->left = nL;
+        else nParent->right = nL;
+        nL->parent = nParent;
+
+        int hNRepl = 1 + max(hLR, hR);
+        n->height = hNRepl;
+        nL->height = 1 + max(hLL, hNRepl);
+
+        n->version = endChange(nodeV);
+
+        int balN = hLR - hR;
+        if (balN < -1 || balN > 1) return n;
+        if ((!nLR || hR == 0) && !n->present.load()) return n;
+        int balL = hLL - hNRepl;
+        if (balL < -1 || balL > 1) return nL;
+        if (hLL == 0 && !nL->present.load()) return nL;
+        return fixHeight_nl(nParent);
+    }
+
+    Node* rotateLeft_nl(Node* nParent, Node* n, int hL, Node* nR, Node* nRL, int hRL, int hRR) {
+        uint64_t nodeV = n->version.load();
+        Node* nPL = nParent->left.load();
+
+        n->version = beginChange(nodeV);
+
+        n->right = nRL;
+        if (nRL) nRL->parent = n;
+        nR->left = n;
+        n->parent = nR;
+        if (nPL == n) nParent->left = nR;
+        else nParent->right = nR;
+        nR->parent = nParent;
+
+        int hNRepl = 1 + max(hL, hRL);
+        n->height = hNRepl;
+        nR->height = 1 + max(hNRepl, hRR);
+
+        n->version = endChange(nodeV);
+
+        int balN = hRL - hL;
+        if (balN < -1 || balN > 1) return n;
+        if ((!nRL || hL == 0) && !n->present.load()) return n;
+        int balR = hRR - hNRepl;
+        if (balR < -1 || balR > 1) return nR;
+        if (hRR == 0 && !nR->present.load()) return nR;
+        return fixHeight_nl(nParent);
+    }
+
+    Node* rotateRightOverLeft_nl(Node* nParent, Node* n, Node* nL, int hR, int hLL, Node* nLR, int hLRL) {
+        uint64_t nodeV = n->version.load();
+        uint64_t leftV = nL->version.load();
+        Node* nPL = nParent->left.load();
+        Node* nLRL = nLR->left.load();
+        Node* nLRR = nLR->right.load();
+        int hLRR = height(nLRR);
+
+        n->version = beginChange(nodeV);
+        nL->version = beginChange(leftV);
+
+        n->left = nLRR;
+        if (nLRR) nLRR->parent = n;
+        nL->right = nLRL;
+        if (nLRL) nLRL->parent = nL;
+        nLR->left = nL;
+        nL->parent = nLR;
+        nLR->right = n;
+        n->parent = nLR;
+        if (nPL == n) nParent->left = nLR;
+        else nParent->right = nLR;
+        nLR->parent = nParent;
+
+        int hNRepl = 1 + max(hLRR, hR);
+        n->height = hNRepl;
+        int hLRepl = 1 + max(hLL, hLRL);
+        nL->height = hLRepl;
+        nLR->height = 1 + max(hLRepl, hNRepl);
+
+        n->version = endChange(nodeV);
+        nL->version = endChange(leftV);
+
+        // a routing nL may be down to one child now; every lock needed to
+        // splice it out is already held
+        if (!nL->present.load() && (hLL == 0 || hLRL == 0) && attemptUnlink_nl(nLR, nL)) {
+            hLRepl = max(hLL, hLRL);
+            nLR->height = 1 + max(hLRepl, hNRepl);
+        }
+
+        int balN = hLRR - hR;
+        if (balN < -1 || balN > 1) return n;
+        if ((!nLRR || hR == 0) && !n->present.load()) return n;
+        int balLR = hLRepl - hNRepl;
+        if (balLR < -1 || balLR > 1) return nLR;
+        return fixHeight_nl(nParent);
+    }
+
+    Node* rotateLeftOverRight_nl(Node* nParent, Node* n, int hL, Node* nR, Node* nRL, int hRR, int hRLR) {
+        uint64_t nodeV = n->version.load();
+        uint64_t rightV = nR->version.load();
+        Node* nPL = nParent->left.load();
+        Node* nRLL = nRL->left.load();
+        Node* nRLR = nRL->right.load();
+        int hRLL = height(nRLL);
+
+        n->version = beginChange(nodeV);
+        nR->version = beginChange(rightV);
+
+        n->right = nRLL;
+        if (nRLL) nRLL->parent = n;
+        nR->left = nRLR;
+        if (nRLR) nRLR->parent = nR;
+        nRL->right = nR;
+        nR->parent = nRL;
+        nRL->left = n;
+        n->parent = nRL;
+        if (nPL == n) nParent->left = nRL;
+        else nParent->right = nRL;
+        nRL->parent = nParent;
+
+        int hNRepl = 1 + max(hL, hRLL);
+        n->height = hNRepl;
+        int hRRepl = 1 + max(hRLR, hRR);
+        nR->height = hRRepl;
+        nRL->height = 1 + max(hNRepl, hRRepl);
+
+        n->version = endChange(nodeV);
+        nR->version = endChange(rightV);
+
+        if (!nR->present.load() && (hRR == 0 || hRLR == 0) && attemptUnlink_nl(nRL, nR)) {
+            hRRepl = max(hRLR, hRR);
+            nRL->height = 1 + max(hNRepl, hRRepl);
+        }
+
+        int balN = hRLL - hL;
+        if (balN < -1 || balN > 1) return n;
+        if ((!nRLL || hL == 0) && !n->present.load()) return n;
+        int balRL = hRRepl - hNRepl;
+        if (balRL < -1 || balRL > 1) return nRL;
+        return fixHeight_nl(nParent);
+    }
+
+    Node* rebalanceToRight_nl(Node* nParent, Node* n, Node* nL, int hR0) {
+        lock_guard<SpinLock> g(nL->lock);
+        int hL = nL->height.load();
+        if (hL - hR0 <= 1) return n;   // retry
+
+        Node* nLR = nL->right.load();
+        int hLL0 = height(nL->left.load());
+        int hLR0 = height(nLR);
+        if (hLL0 >= hLR0) return rotateRight_nl(nParent, n, nL, hR0, hLL0, nLR, hLR0);
+
+        {
+            lock_guard<SpinLock> g2(nLR->lock);
+            int hLR = nLR->height.load();
+            if (hLL0 >= hLR) return rotateRight_nl(nParent, n, nL, hR0, hLL0, nLR, hLR);
+
+            // only roll the rotation of nL into a double rotation if that
+            // leaves nL balanced
+            int hLRL = height(nLR->left.load());
+            int b = hLL0 - hLRL;
+            if (b >= -1 && b <= 1)
+                return rotateRightOverLeft_nl(nParent, n, nL, hR0, hLL0, nLR, hLRL);
+        }
+        // fix nL on its own; n is revisited afterwards if needed
+        return rebalanceToLeft_nl(n, nL, nLR, hLL0);
+    }
+
+    Node* rebalanceToLeft_nl(Node* nParent, Node* n, Node* nR, int hL0) {
+        lock_guard<SpinLock> g(nR->lock);
+        int hR = nR->height.load();
+        if (hL0 - hR >= -1) return n;   // retry
+
+        Node* nRL = nR->left.load();
+        int hRL0 = height(nRL);
+        int hRR0 = height(nR->right.load());
+        if (hRR0 >= hRL0) return rotateLeft_nl(nParent, n, hL0, nR, nRL, hRL0, hRR0);
+
+        {
+            lock_guard<SpinLock> g2(nRL->lock);
+            int hRL = nRL->height.load();
+            if (hRR0 >= hRL) return rotateLeft_nl(nParent, n, hL0, nR, nRL, hRL, hRR0);
+
+            int hRLR = height(nRL->right.load());
+            int b = hRR0 - hRLR;
+            if (b >= -1 && b <= 1)
+                return rotateLeftOverRight_nl(nParent, n, hL0, nR, nRL, hRR0, hRLR);
+        }
+        return rebalanceToRight_nl(n, nR, nRL, hRR0);
+    }
+
+    Node* rebalance_nl(Node* nParent, Node* n) {
+        Node* nL = n->left.load();
+        Node* nR = n->right.load();
+        if ((!nL || !nR) && !n->present.load()) {
+            if (attemptUnlink_nl(nParent, n)) return fixHeight_nl(nParent);
+            return n;
+        }
+
+        int hN = n->height.load();
+        int hL0 = height(nL), hR0 = height(nR);
+        int hNRepl = 1 + max(hL0, hR0);
+        int bal = hL0 - hR0;
+
+        if (bal > 1) return rebalanceToRight_nl(nParent, n, nL, hR0);
+        if (bal < -1) return rebalanceToLeft_nl(nParent, n, nR, hL0);
+        if (hNRepl != hN) {
+            n->height = hNRepl;
+            return fixHeight_nl(nParent);
+        }
+        return nullptr;
+    }
+
+    void fixHeightAndRebalance(Node* node) {
+        while (node && node->parent.load()) {
+            int c = nodeCondition(node);
+            if (c == NOTHING_REQUIRED || (node->version.load() & UNLINKED)) return;
+
+            if (c != UNLINK_REQUIRED && c != REBALANCE_REQUIRED) {
+                lock_guard<SpinLock> g(node->lock);
+                node = fixHeight_nl(node);
+            } else {
+                Node* nParent = node->parent.load();
+                lock_guard<SpinLock> g(nParent->lock);
+                if (!(nParent->version.load() & UNLINKED) && node->parent.load() == nParent) {
+                    lock_guard<SpinLock> g2(node->lock);
+                    node = rebalance_nl(nParent, node);
+                }
+            }
+        }
+    }
+
+    // ---- updates ----
+
+    int attemptNodeUpdate(bool insert, Node* parent, Node* node) {
+        if (!insert) {
+            if (!node->present.load()) return 0;
+
+            if (!node->left.load() || !node->right.load()) {
+                Node* damaged;
+                {
+                    lock_guard<SpinLock> g(parent->lock);
+                    if ((parent->version.load() & UNLINKED) || node->parent.load() != parent) return RETRY;
+                    {
+                        lock_guard<SpinLock> g2(node->lock);
+                        if (!node->present.load()) return 0;
+                        if (!attemptUnlink_nl(parent, node)) return RETRY;
+                    }
+                    damaged = fixHeight_nl(parent);
+                }
+                fixHeightAndRebalance(damaged);
+                return 1;
+            }
+        }
+
+        lock_guard<SpinLock> g(node->lock);
+        if (node->version.load() & UNLINKED) return RETRY;
+        if (node->present.load() == insert) return 0;
+        // it may have lost a child since we looked; then unlink instead
+        if (!insert && (!node->left.load() || !node->right.load())) return RETRY;
+        node->present = insert;
+        return 1;
+    }
+
+    int attemptUpdate(int key, bool insert, Node* parent, Node* node, uint64_t nodeV) {
+        if (key == node->key) return attemptNodeUpdate(insert, parent, node);
+        int dir = key < node->key ? -1 : 1;
+
+        while (true) {
+            Node* child = node->child(dir).load();
+            if (node->version.load() != nodeV) return RETRY;
+
+            if (!child) {
+                if (!insert) return 0;
+                Node* damaged = nullptr;
+                bool attached = false;
+                {
+                    lock_guard<SpinLock> g(node->lock);
+                    if (node->version.load() != nodeV) return RETRY;
+                    if (!node->child(dir).load()) {
+                        node->child(dir) = new Node(key, true, node);
+                        attached = true;
+                        damaged = fixHeight_nl(node);
+                    }
+                }
+                if (attached) {
+                    fixHeightAndRebalance(damaged);
+                    return 1;
+                }
+                // lost a race with another insert; look again
+            } else {
+                uint64_t childV = child->version.load();
+                if (shrinkingOrUnlinked(childV)) {
+                    waitUntilShrinkCompleted(child, childV);
+                } else if (child == node->child(dir).load()) {
+                    if (node->version.load() != nodeV) return RETRY;
+                    int r = attemptUpdate(key, insert, node, child, childV);
+                    if (r != RETRY) return r;
+                }
+            }
+        }
+    }
+
+    bool updateFromRoot(int key, bool insert) {
+        while (true) {
+            Node* root = holder.right.load();
+            if (!root) {
+                if (!insert) return false;
+                lock_guard<SpinLock> g(holder.lock);
+                if (!holder.right.load()) {
+                    holder.right = new Node(key, true, &holder);
+                    holder.height = 2;
+                    return true;
+                }
+                continue;
+            }
+            uint64_t v = root->version.load();
+            if (shrinkingOrUnlinked(v)) {
+                waitUntilShrinkCompleted(root, v);
+            } else if (root == holder.right.load()) {
+                int r = attemptUpdate(key, insert, &holder, root, v);
+                if (r != RETRY) return r;
+            }
+        }
+    }
+
+    bool update(int key, bool insert) {
+        Guard guard;
+        bool changed = updateFromRoot(key, insert);
+        retire();
+        return changed;
+    }
+
+    static void destroy(Node* n) {
+        if (!n) return;
+        destroy(n->left.load());
+        destroy(n->right.load());
+        delete n;
+    }
+
+    static bool check(Node* n, Node* parent, long long lo, long long hi, size_t& count) {
+        if (!n) return true;
+        if (n->parent.load() != parent || n->key <= lo || n->key >= hi) return false;
+        if (n->version.load() & UNLINKED) return false;
+        if (!n->present.load() && (!n->left.load() || !n->right.load())) return false;
+        count += n->present.load();
+        return check(n->left.load(), n, lo, n->key, count) && check(n->right.load(), n, n->key, hi, count);
+    }
+
+public:
+    ConcurrentAVL() {}
+    ConcurrentAVL(const ConcurrentAVL&) = delete;
+    ConcurrentAVL& operator=(const ConcurrentAVL&) = delete;
+
+    // must not race with any other operation
+    ~ConcurrentAVL() {
+        destroy(holder.right.load());
+        for (auto& list : retireLists) {
+            for (Node* n : list.unlinked) delete n;
+            for (auto& r : list.retired) delete r.first;
+        }
+    }
+
+    bool contains(int key) {
+        Guard guard;
+        while (true) {
+            Node* root = holder.right.load();
+            if (!root) return false;
+            if (key == root->key) return root->present.load();
+            uint64_t v = root->version.load();
+            if (shrinkingOrUnlinked(v)) {
+                waitUntilShrinkCompleted(root, v);
+            } else if (root == holder.right.load()) {
+                int r = attemptGet(key, root, key < root->key ? -1 : 1, v);
+                if (r != RETRY) return r;
+            }
+        }
+    }
+
+    bool insert(int key) { return update(key, true); }
+
+    bool remove(int key) { return update(key, false); }
+
+    // Structural check for a quiescent tree: BST order, parent links, no
+    // unlinked node still reachable and no routing node left with fewer
+    // than two children. Stores the number of keys in `count`.
+    bool validate(size_t& count) {
+        count = 0;
+        return check(holder.right.load(), &holder, (long long)INT32_MIN - 1, (long long)INT32_MAX + 1, count);
+    }
+};
+
+// Same interface behind one global mutex, as the scaling baseline
+class LockedSet {
+private:
+    mutex m;
+    set<int> s;
+
+public:
+    bool contains(int key) {
+        lock_guard<mutex> g(m);
+        return s.count(key) > 0;
+    }
+
+    bool insert(int key) {
+        lock_guard<mutex> g(m);
+        return s.insert(key).second;
+    }
+
+    bool remove(int key) {
+        lock_guard<mutex> g(m);
+        return s.erase(key) > 0;
+    }
+};
+
+// Every thread runs random ops on a small key range and counts, per key,
+// its successful inserts minus successful removes. At the end every key's
+// total must be 0 or 1 and agree with contains(), and the tree must pass
+// validate().
+bool stressTest(int threads, int opsPerThread, int keyRange) {
+    ConcurrentAVL tree;
+    vector<vector<int>> net(threads, vector<int>(keyRange, 0));
+    vector<thread> pool;
+
+    for (int t = 0; t < threads; t++) {
+        pool.emplace_back([&, t] {
+            mt19937 rng(1234 + t);
+            for (int i = 0; i < opsPerThread; i++) {
+                int key = rng() % keyRange;
+                int op = rng() % 3;
+                if (op == 0) tree.contains(key);
+                else if (op == 1) net[t][key] += tree.insert(key);
+                else net[t][key] -= tree.remove(key);
+            }
+        });
+    }
+    for (thread& th : pool) th.join();
+
+    size_t expected = 0;
+    for (int key = 0; key < keyRange; key++) {
+        int total = 0;
+        for (int t = 0; t < threads; t++) total += net[t][key];
+        if (total != 0 && total != 1) return false;
+        if (tree.contains(key) != (total == 1)) return false;
+        expected += total;
+    }
+
+    size_t count;
+    return tree.validate(count) && count == expected;
+}
+
+// Millions of ops per second for `threads` threads over `seconds`, with
+// readPercent of the ops being contains() and the rest split evenly
+// between insert and remove on a half-full key range.
+template <class Set>
+double throughput(int threads, int readPercent, int keyRange, double seconds) {
+    Set s;
+    mt19937 fill(7);
+    for (int i = 0; i < keyRange / 2; i++) s.insert(fill() % keyRange);
+
+    atomic<bool> go{false}, stop{false};
+    atomic<long long> total{0}, hits{0};
+    vector<thread> pool;
+
+    for (int t = 0; t < threads; t++) {
+        pool.emplace_back([&, t] {
+            mt19937 rng(99 + t);
+            long long ops = 0, found = 0;
+            while (!go.load()) this_thread::yield();
+            while (!stop.load(memory_order_relaxed)) {
+                for (int i = 0; i < 64; i++) {
+                    int key = rng() % keyRange;
+                    int dice = rng() % 100;
+                    if (dice < readPercent) found += s.contains(key);
+                    else if (dice % 2) found += s.insert(key);
+                    else found += s.remove(key);
+                }
+                ops += 64;
+            }
+            total += ops;
+            hits += found;   // keeps the lookups from being optimized out
+        });
+    }
+
+    go = true;
+    this_thread::sleep_for(chrono::duration<double>(seconds));
+    stop = true;
+    for (thread& th : pool) th.join();
+    return total.load() / seconds / 1e6;
+}
+
+void evaluateScaling(int maxThreads) {
+    const int KEY_RANGE = 1 << 20;
+    const double SECONDS = 0.5;
+    const int READ_MIX[] = {100, 90, 50};
+
+    cout << "\nScaling (Mops/s, key range " << KEY_RANGE << "):\n";
+    cout << "====================================================================================\n";
+    cout << setw(10) << "Threads";
+    for (int r : READ_MIX)
+        cout << setw(14) << (to_string(r) + "% rd AVL") << setw(14) << (to_string(r) + "% rd lock");
+    cout << endl;
+    cout << "------------------------------------------------------------------------------------\n";
+
+    // powers of two below maxThreads, then maxThreads itself
+    vector<int> counts;
+    for (int t = 1; t < maxThreads; t *= 2) counts.push_back(t);
+    counts.push_back(maxThreads);
+
+    for (int t : counts) {
+        cout << setw(10) << t;
+        for (int r : READ_MIX) {
+            cout << setw(14) << fixed << setprecision(2) << throughput<ConcurrentAVL>(t, r, KEY_RANGE, SECONDS);
+            cout << setw(14) << fixed << setprecision(2) << throughput<LockedSet>(t, r, KEY_RANGE, SECONDS);
+        }
+        cout << endl;
+    }
+    cout << "====================================================================================\n";
+}
+
+int main(int argc, char* argv[]) {
+    int maxThreads = argc > 1 ? atoi(argv[1]) : (int)max(1u, thread::hardware_concurrency());
+    if (maxThreads < 1) maxThreads = 1;
+
+    cout << "Concurrent AVL - stress test and scaling benchmark\n";
+    cout << "  Threads: 1.." << maxThreads << endl;
+
+    bool ok = true;
+    for (int t : {1, 2, 4, 8}) {
+        bool pass = stressTest(t, 200000, 2000);
+        cout << "  Stress " << t << " threads: " << (pass ? "ok" : "FAILED") << endl;
+        ok = ok && pass;
+    }
+
+    evaluateScaling(maxThreads);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,109 @@
+#ifndef FAST_IO_H
+#define FAST_IO_H
+
+#include<cstdio>
+#include<cstddef>
+
+// Block-buffered stdin/stdout for the offline op-stream drivers. Input is
+// pulled in 1 MiB freads and integers are parsed by hand; output collects
+// in a 1 MiB block that goes out with one fwrite when it fills and once
+// more on destruction. Neither side touches iostream.
+
+class InBuf {
+private:
+    static const size_t CAP = 1 << 20;
+    char buf[CAP];
+    size_t len = 0, pos = 0;
+    bool ok = true;
+
+    int peek() {
+        if (pos == len) {
+            len = fread(buf, 1, CAP, stdin);
+            pos = 0;
+            if (len == 0) return EOF;
+        }
+        return (unsigned char)buf[pos];
+    }
+
+public:
+    // Reads the next (optionally signed) decimal integer. At end of input
+    // v is left as 0 and the reader tests false.
+    InBuf& operator>>(int& v) {
+        int c = peek();
+        while (c != EOF && c != '-' && (c < '0' || c > '9')) {
+            pos++;
+            c = peek();
+        }
+        v = 0;
+        if (c == EOF) {
+            ok = false;
+            return *this;
+        }
+        bool neg = c == '-';
+        if (neg) {
+            pos++;
+            c = peek();
+        }
+        unsigned u = 0;
+        while (c >= '0' && c <= '9') {
+            u = u * 10 + (c - '0');
+            pos++;
+            c = peek();
+        }
+        v = neg ? (int)(0u - u) : (int)u;
+        return *this;
+    }
+
+    explicit operator bool() const { return ok; }
+};
+
+class OutBuf {
+private:
+    static const size_t CAP = 1 << 20;
+    char buf[CAP];
+    size_t len = 0;
+    bool muted = false;
+
+public:
+    ~OutBuf() { flush(); }
+
+    void flush() {
+        if (!muted) fwrite(buf, 1, len, stdout);
+        len = 0;
+    }
+
+    // drops everything from here on, for runs that only time the work
+    void mute() {
+        muted = true;
+        len = 0;
+    }
+
+    OutBuf& operator<<(char c) {
+        if (len == CAP) flush();
+        buf[len++] = c;
+        return *this;
+    }
+
+    OutBuf& operator<<(const char* str) {
+        while (*str) *this << *str++;
+        return *this;
+    }
+
+    OutBuf& operator<<(long long v) {
+        if (len + 24 > CAP) flush();
+        char tmp[24];
+        int n = 0;
+        unsigned long long u = v < 0 ? 0ULL - (unsigned long long)v : (unsigned long long)v;
+        do {
+            tmp[n++] = char('0' + u % 10);
+            u /= 10;
+        } while (u);
+        if (v < 0) buf[len++] = '-';
+        while (n) buf[len++] = tmp[--n];
+        return *this;
+    }
+
+    OutBuf& operator<<(int v) { return *this << (long long)v; }
+};
+
+#endif
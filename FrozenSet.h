@@ -0,0 +1,74 @@
+#ifndef FROZEN_SET_H
+#define FROZEN_SET_H
+
+#include<vector>
+#include<cstddef>
+
+// Read-only snapshot of a sorted key set in Eytzinger (BFS) order: the
+// root sits at index 1 and the children of k at 2k and 2k+1, so the top
+// levels of every search share a few cache lines and the next levels can
+// be prefetched before they are needed. Searches are branch-free: each
+// step is one compare folded into the next index.
+//
+// Built by AVL::freeze() and RedBlackTree::freeze() for read-mostly
+// phases; it does not follow later updates to the tree.
+class FrozenSet {
+private:
+    std::vector<int> keys;    // Eytzinger order, keys[0] unused
+    std::vector<int> ranks;   // ranks[k]: number of keys smaller than keys[k]
+    size_t n = 0;
+
+    // in-order walk of the implicit tree hands out the sorted keys
+    size_t fill(const std::vector<int>& sorted, size_t i, size_t k) {
+        if (k > n) return i;
+        i = fill(sorted, i, 2 * k);
+        keys[k] = sorted[i];
+        ranks[k] = (int)i;
+        return fill(sorted, i + 1, 2 * k + 1);
+    }
+
+    // index of the first key >= x, or 0 if there is none
+    size_t lowerBound(int x) const {
+        const int* a = keys.data();
+        size_t k = 1;
+        while (k <= n) {
+#if defined(__GNUC__)
+            // 16 ints per cache line: fetch the line four levels down
+            __builtin_prefetch(a + k * 16);
+#endif
+            k = 2 * k + (a[k] < x);
+        }
+        // undo the trailing right turns plus the final left turn
+#if defined(__GNUC__)
+        k >>= __builtin_ffsll((long long)~k);
+#else
+        while (k & 1) k >>= 1;
+        k >>= 1;
+#endif
+        return k;
+    }
+
+public:
+    FrozenSet() : keys(1), ranks(1) {}
+
+    // `sorted` must be strictly increasing
+    explicit FrozenSet(const std::vector<int>& sorted)
+        : keys(sorted.size() + 1), ranks(sorted.size() + 1), n(sorted.size()) {
+        fill(sorted, 0, 1);
+    }
+
+    size_t size() const { return n; }
+
+    bool contains(int x) const {
+        size_t k = lowerBound(x);
+        return k && keys[k] == x;
+    }
+
+    // number of keys < x
+    int countLess(int x) const {
+        size_t k = lowerBound(x);
+        return k ? ranks[k] : (int)n;
+    }
+};
+
+#endif
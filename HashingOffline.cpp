@@ -6,6 +6,12 @@
 #include <unordered_set>
 #include <iomanip>
 #include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 using namespace std;
 
@@ -18,16 +24,23 @@ const double COMPACTION_THRESHOLD = 0.25;
 const int C1 = 1;
 const int C2 = 3;
 
-// Hash table entry
+// Swiss table: grows past 7/8 full, live slots and tombstones together
+const int SWISS_MAX_LOAD_NUM = 7;
+const int SWISS_MAX_LOAD_DEN = 8;
+
+// Hash table entry. The key's hash is kept beside it, so a resize places
+// it without hashing the key again and a probe can reject it without
+// comparing strings.
 template <typename K, typename V>
 struct Entry
 {
     K key;
     V value;
+    uint64_t hash; // hashFunc(key)
     bool isDeleted;
 
-    Entry() : isDeleted(false) {}
-    Entry(K k, V v) : key(k), value(v), isDeleted(false) {}
+    Entry() : hash(0), isDeleted(false) {}
+    Entry(K k, V v, uint64_t h) : key(k), value(v), hash(h), isDeleted(false) {}
 };
 
 // Node for chaining
@@ -36,9 +49,10 @@ struct ChainNode
 {
     K key;
     V value;
+    uint64_t hash; // hashFunc(key)
     ChainNode *next;
 
-    ChainNode(K k, V v) : key(k), value(v), next(nullptr) {}
+    ChainNode(K k, V v, uint64_t h) : key(k), value(v), hash(h), next(nullptr) {}
 };
 
 // Utility functions
@@ -83,24 +97,35 @@ int prevPrime(int n)
     return prime;
 }
 
-// Hash functions
-int hash1(const string &key, int tableSize)
+// Hash functions. Each maps a key to 64 bits that do not depend on the
+// table size, so a key is hashed once however many slots it is tried in;
+// reduceHash() then turns the value into a slot index.
+typedef uint64_t (*HashFunction)(const string &);
+
+int reduceHash(uint64_t hash, int tableSize)
+{
+    return (int)(hash % (uint64_t)tableSize);
+}
+
+uint64_t hash1(const string &key)
 {
-    // Polynomial rolling hash (Horner's method)
-    unsigned long long hash = 0;
+    // Polynomial rolling hash (Horner's method), wrapping mod 2^64; for
+    // keys of up to 12 characters nothing wraps, so reducing it gives the
+    // same slot as reducing term by term
+    uint64_t hash = 0;
     const int p = 31; // prime number
-    unsigned long long p_pow = 1;
+    uint64_t p_pow = 1;
 
     for (char c : key)
     {
-        hash = (hash + (c - 'a' + 1) * p_pow) % tableSize;
-        p_pow = (p_pow * p) % tableSize;
+        hash += (c - 'a' + 1) * p_pow;
+        p_pow *= p;
     }
 
     return hash;
 }
 
-int hash2(const string &key, int tableSize)
+uint64_t hash2(const string &key)
 {
     // FNV-1a hash adapted for string
     unsigned long long hash = 2166136261u;
@@ -112,20 +137,91 @@ int hash2(const string &key, int tableSize)
         hash *= FNV_prime;
     }
 
-    return hash % tableSize;
+    return hash;
 }
 
-int auxHash(const string &key, int tableSize)
+// 64x64 -> 128 bit product with the halves folded together
+inline uint64_t foldedMultiply(uint64_t a, uint64_t b)
 {
-    // Simple auxiliary hash for double hashing
-    // Returns a value between 1 and tableSize-1
-    int h = 0;
-    for (char c : key)
+#if defined(__SIZEOF_INT128__)
+    unsigned __int128 r = (unsigned __int128)a * b;
+    return (uint64_t)r ^ (uint64_t)(r >> 64);
+#else
+    // schoolbook product of the 32-bit halves
+    uint64_t aLo = (uint32_t)a, aHi = a >> 32, bLo = (uint32_t)b, bHi = b >> 32;
+    uint64_t ll = aLo * bLo, lh = aLo * bHi, hl = aHi * bLo, hh = aHi * bHi;
+    uint64_t mid = (ll >> 32) + (uint32_t)lh + (uint32_t)hl;
+    uint64_t lo = (mid << 32) | (uint32_t)ll;
+    uint64_t hi = hh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+    return lo ^ hi;
+#endif
+}
+
+// unaligned little-endian loads of exactly 8 and 4 bytes
+inline uint64_t read64(const char *p)
+{
+    uint64_t v;
+    memcpy(&v, p, 8);
+    return v;
+}
+
+inline uint64_t read32(const char *p)
+{
+    uint32_t v;
+    memcpy(&v, p, 4);
+    return v;
+}
+
+uint64_t hash3(const string &key)
+{
+    // wyhash-style: mixes 8 bytes per step with one folded multiply
+    // instead of a multiply (and two modulos) per character. The last
+    // word is read as fixed-size loads that may overlap bytes already
+    // mixed, never as a variable-length copy; the length, spread over the
+    // whole seed, keeps keys whose bytes coincide apart.
+    const uint64_t K0 = 0xa0761d6478bd642full;
+    const uint64_t K1 = 0xe7037ed1a0b428dbull;
+    const uint64_t K2 = 0x8ebc6af09c88c6e3ull;
+
+    const char *p = key.data();
+    size_t n = key.size();
+    uint64_t hash = K0 ^ n * K2;
+    uint64_t last;
+
+    if (n >= 8)
+    {
+        for (; n > 8; p += 8, n -= 8)
+        {
+            hash = foldedMultiply(hash ^ read64(p), K1);
+        }
+        last = read64(p + n - 8);
+    }
+    else if (n >= 4)
+    {
+        last = read32(p) << 32 | read32(p + n - 4);
+    }
+    else if (n > 0)
     {
-        h = (h * 37 + c) % (tableSize - 1);
+        last = (uint64_t)(unsigned char)p[0] << 16 | (uint64_t)(unsigned char)p[n / 2] << 8 |
+               (unsigned char)p[n - 1];
     }
-    return h + 1; // Ensure non-zero
-}   // auxHash (h2) cannot be 0 or table_size 
+    else
+    {
+        last = 0;
+    }
+
+    return foldedMultiply(foldedMultiply(hash ^ last, K1), K2);
+}
+
+int auxStep(uint64_t hash, int tableSize)
+{
+    // Step for double hashing, from the high bits of the same 64-bit
+    // hash that gives the home slot, so a key is still read only once.
+    // The hash is remixed first because hash1 leaves the high bits clear
+    // on short keys. Returns a value between 1 and tableSize-1.
+    uint64_t high = (hash * 0x9E3779B97F4A7C15ull) >> 32;
+    return (int)(high % (uint64_t)(tableSize - 1)) + 1; // Ensure non-zero
+}   // auxStep (h2) cannot be 0 or table_size 
 
 
 
@@ -169,37 +265,56 @@ class ChainingHashTable : public HashTableBase<K, V>
 {
 private:
     vector<ChainNode<K, V> *> table;
-    int (*hashFunc)(const string &, int);
+    HashFunction hashFunc;
+
+    // Insert at head of the node's bucket
+    void link(ChainNode<K, V> *node)
+    {
+        int index = reduceHash(node->hash, this->tableSize);
+
+        // Count collision if chain already exists
+        if (table[index] != nullptr)
+        {
+            this->collisionCount++;
+        }
+
+        node->next = table[index];
+        table[index] = node;
+        this->numElements++;
+        this->insertionsSinceExpansion++;
+    }
 
     void resize(int newSize)
     {
-        vector<ChainNode<K, V> *> oldTable = table;
+        vector<ChainNode<K, V> *> oldTable = std::move(table);
         int oldSize = this->tableSize;
 
-        table.clear();
-        table.resize(newSize, nullptr);
+        table.assign(newSize, nullptr);
         this->tableSize = newSize;
         this->numElements = 0;
 
-        // Rehash all elements
+        // Relink all nodes by their stored hashes
         for (int i = 0; i < oldSize; i++)
         {
             ChainNode<K, V> *current = oldTable[i];
             while (current != nullptr)
             {
+                ChainNode<K, V> *next = current->next;
                 if (!current->key.empty())
                 {
-                    insert(current->key, current->value);
+                    link(current);
                 }
-                ChainNode<K, V> *temp = current;
-                current = current->next;
-                delete temp;
+                else
+                {
+                    delete current;
+                }
+                current = next;
             }
         }
     }
 
 public:
-    ChainingHashTable(int (*hf)(const string &, int), int size = INITIAL_TABLE_SIZE)
+    ChainingHashTable(HashFunction hf, int size = INITIAL_TABLE_SIZE)
         : HashTableBase<K, V>(size), hashFunc(hf)
     {
         table.resize(size, nullptr);
@@ -221,31 +336,21 @@ public:
 
     bool insert(const K &key, const V &value) override
     {
-        int index = hashFunc(key, this->tableSize);
+        uint64_t hash = hashFunc(key);
+        int index = reduceHash(hash, this->tableSize);
 
         // Check if key already exists
         ChainNode<K, V> *current = table[index];
         while (current != nullptr)
         {
-            if (current->key == key)
+            if (current->hash == hash && current->key == key)
             {
                 return false; // Key already exists
             }
             current = current->next;
         }
 
-        // Count collision if chain already exists
-        if (table[index] != nullptr)
-        {
-            this->collisionCount++;
-        }
-
-        // Insert at head
-        ChainNode<K, V> *newNode = new ChainNode<K, V>(key, value);
-        newNode->next = table[index];
-        table[index] = newNode;
-        this->numElements++;
-        this->insertionsSinceExpansion++;
+        link(new ChainNode<K, V>(key, value, hash));
 
         // Check for expansion
         if (this->getLoadFactor() > LOAD_FACTOR_THRESHOLD &&
@@ -262,13 +367,14 @@ public:
     bool search(const K &key, V &value, int &hits) override
     {
         hits = 0;
-        int index = hashFunc(key, this->tableSize);
+        uint64_t hash = hashFunc(key);
+        int index = reduceHash(hash, this->tableSize);
 
         ChainNode<K, V> *current = table[index];
         while (current != nullptr)
         {
             hits++;
-            if (current->key == key)
+            if (current->hash == hash && current->key == key)
             {
                 value = current->value;
                 return true;
@@ -281,14 +387,15 @@ public:
 
     bool remove(const K &key) override
     {
-        int index = hashFunc(key, this->tableSize);
+        uint64_t hash = hashFunc(key);
+        int index = reduceHash(hash, this->tableSize);
 
         ChainNode<K, V> *current = table[index];
         ChainNode<K, V> *prev = nullptr;
 
         while (current != nullptr)
         {
-            if (current->key == key)
+            if (current->hash == hash && current->key == key)
             {
                 if (prev == nullptr)
                 {
@@ -325,6 +432,32 @@ public:
     }
 };
 
+// Probe sequence (h1 + c1*i*h2 + c2*i*i) % tableSize of one key. Both
+// hashes are computed once, up front; moving from i to i+1 adds the
+// current step and grows the step by 2*c2, so each probe costs two
+// modular additions instead of two passes over the key.
+struct ProbeSequence
+{
+    int index;      // slot for the current i
+    int step;       // index(i+1) - index(i), mod tableSize
+    int growth;     // step(i+1) - step(i), mod tableSize
+    int tableSize;
+
+    ProbeSequence(int h1, int h2, int c1, int c2, int size)
+        : index(h1 % size), step((int)(((long long)c1 * h2 + c2) % size)),
+          growth((int)(2LL * c2 % size)), tableSize(size) {}
+
+    void next()
+    {
+        index += step;
+        if (index >= tableSize)
+            index -= tableSize;
+        step += growth;
+        if (step >= tableSize)
+            step -= tableSize;
+    }
+};
+
 // Open Addressing Base Class
 template <typename K, typename V>
 class OpenAddressingHashTable : public HashTableBase<K, V>
@@ -332,14 +465,15 @@ class OpenAddressingHashTable : public HashTableBase<K, V>
 protected:
     vector<Entry<K, V>> table;
     vector<bool> occupied;
-    int (*hashFunc)(const string &, int);
+    HashFunction hashFunc;
 
-    virtual int probe(const K &key, int i) = 0;
+    // probes of a key with this hash, at the current table size
+    virtual ProbeSequence probeSequence(uint64_t hash) = 0;
 
     void resize(int newSize)
     {
-        vector<Entry<K, V>> oldTable = table;
-        vector<bool> oldOccupied = occupied;
+        vector<Entry<K, V>> oldTable = std::move(table);
+        vector<bool> oldOccupied = std::move(occupied);
         int oldSize = this->tableSize;
 
         table.clear();
@@ -349,18 +483,43 @@ protected:
         this->tableSize = newSize;
         this->numElements = 0;
 
-        // Rehash all elements
+        // Move all elements by their stored hashes. insert() keeps the
+        // keys distinct and the new table has no deleted slots, so each one goes to the
+        // first unoccupied slot of its probe sequence. Those land all over
+        // a large table, so the home slot of an element a few places ahead
+        // is prefetched while this one is placed.
+        const int PREFETCH_AHEAD = 8;
         for (int i = 0; i < oldSize; i++)
         {
+            int ahead = i + PREFETCH_AHEAD;
+            if (ahead < oldSize && oldOccupied[ahead] && !oldTable[ahead].isDeleted)
+            {
+#if defined(__GNUC__)
+                __builtin_prefetch(&table[reduceHash(oldTable[ahead].hash, newSize)], 1);
+#endif
+            }
+
             if (oldOccupied[i] && !oldTable[i].isDeleted)
             {
-                insert(oldTable[i].key, oldTable[i].value);
+                ProbeSequence seq = probeSequence(oldTable[i].hash);
+                if (occupied[seq.index])
+                {
+                    this->collisionCount++;
+                    do
+                    {
+                        seq.next();
+                    } while (occupied[seq.index]);
+                }
+                table[seq.index] = std::move(oldTable[i]);
+                occupied[seq.index] = true;
+                this->numElements++;
+                this->insertionsSinceExpansion++;
             }
         }
     }
 
 public:
-    OpenAddressingHashTable(int (*hf)(const string &, int), int size = INITIAL_TABLE_SIZE)
+    OpenAddressingHashTable(HashFunction hf, int size = INITIAL_TABLE_SIZE)
         : HashTableBase<K, V>(size), hashFunc(hf)
     {
         table.resize(size);
@@ -378,45 +537,72 @@ public:
         }
 
         int i = 0;
+        uint64_t hash = hashFunc(key);
+        ProbeSequence seq = probeSequence(hash);
+
+        // The key may still sit further along past a deleted slot, so the
+        // first deleted slot is only remembered; it is reused once the
+        // chain has been followed to its end without finding the key.
+        int target = -1;
         bool collisionOccurred = false;
 
         while (i < this->tableSize) // traverse through table
         {
-            int index = probe(key, i); // new element er jonno find index
+            int index = seq.index; // new element er jonno find index
 
-            if (!occupied[index] || table[index].isDeleted)
+            if (!occupied[index])
             {
-                table[index] = Entry<K, V>(key, value);
-                occupied[index] = true;
-                this->numElements++;
-                this->insertionsSinceExpansion++;
-                if (collisionOccurred)
+                if (target < 0)
                 {
-                    this->collisionCount++;
+                    target = index;
+                    collisionOccurred = i > 0;
                 }
-                return true;
+                break;
             }
 
-            if (table[index].key == key) // Key already exists
+            if (table[index].isDeleted)
+            {
+                if (target < 0)
+                {
+                    target = index;
+                    collisionOccurred = i > 0; // at that index onno element chilo
+                }
+            }
+            else if (table[index].hash == hash && table[index].key == key) // Key already exists
             {
                 return false;
             }
 
-            collisionOccurred = true; // at that index onno element chilo
             i++;
+            seq.next();
+        }
+
+        if (target < 0)
+        {
+            return false; // Table full
         }
 
-        return false; // Table full
+        table[target] = Entry<K, V>(key, value, hash);
+        occupied[target] = true;
+        this->numElements++;
+        this->insertionsSinceExpansion++;
+        if (collisionOccurred)
+        {
+            this->collisionCount++;
+        }
+        return true;
     }
 
     bool search(const K &key, V &value, int &hits) override
     {
         hits = 0;
         int i = 0;
+        uint64_t hash = hashFunc(key);
+        ProbeSequence seq = probeSequence(hash);
 
         while (i < this->tableSize) // traverse through table
         {
-            int index = probe(key, i);
+            int index = seq.index;
             hits++;
 
             if (!occupied[index])
@@ -424,13 +610,14 @@ public:
                 return false; // Empty slot, key not found
             }
 
-            if (!table[index].isDeleted && table[index].key == key)
+            if (!table[index].isDeleted && table[index].hash == hash && table[index].key == key)
             {
                 value = table[index].value;
                 return true;
             }
 
             i++;
+            seq.next();
         }
 
         return false;
@@ -439,17 +626,19 @@ public:
     bool remove(const K &key) override
     {
         int i = 0;
+        uint64_t hash = hashFunc(key);
+        ProbeSequence seq = probeSequence(hash);
 
         while (i < this->tableSize)
         {
-            int index = probe(key, i);
+            int index = seq.index;
 
             if (!occupied[index])
             {
                 return false;
             }
 
-            if (!table[index].isDeleted && table[index].key == key)
+            if (!table[index].isDeleted && table[index].hash == hash && table[index].key == key)
             {
                 table[index].isDeleted = true;
                 this->numElements--;
@@ -471,6 +660,7 @@ public:
             }
 
             i++;
+            seq.next();
         }
 
         return false;
@@ -482,15 +672,16 @@ template <typename K, typename V>
 class DoubleHashingTable : public OpenAddressingHashTable<K, V>
 {
 protected:
-    int probe(const K &key, int i) override
+    // (h1 + i * h2) % tableSize
+    ProbeSequence probeSequence(uint64_t hash) override
     {
-        int h1 = this->hashFunc(key, this->tableSize);
-        int h2 = auxHash(key, this->tableSize);
-        return (h1 + i * h2) % this->tableSize;
+        int h1 = reduceHash(hash, this->tableSize);
+        int h2 = auxStep(hash, this->tableSize);
+        return ProbeSequence(h1, h2, 1, 0, this->tableSize);
     }
 
 public:
-    DoubleHashingTable(int (*hf)(const string &, int), int size = INITIAL_TABLE_SIZE)
+    DoubleHashingTable(HashFunction hf, int size = INITIAL_TABLE_SIZE)
         : OpenAddressingHashTable<K, V>(hf, size) {}
 };
 
@@ -499,18 +690,302 @@ template <typename K, typename V>
 class CustomProbingTable : public OpenAddressingHashTable<K, V>
 {
 protected:
-    int probe(const K &key, int i) override
+    // (h1 + C1 * i * h2 + C2 * i * i) % tableSize
+    ProbeSequence probeSequence(uint64_t hash) override
     {
-        int h1 = this->hashFunc(key, this->tableSize);
-        int h2 = auxHash(key, this->tableSize);
-        return (h1 + C1 * i * h2 + C2 * i * i) % this->tableSize;
+        int h1 = reduceHash(hash, this->tableSize);
+        int h2 = auxStep(hash, this->tableSize);
+        return ProbeSequence(h1, h2, C1, C2, this->tableSize);
     }
 
 public:
-    CustomProbingTable(int (*hf)(const string &, int), int size = INITIAL_TABLE_SIZE)
+    CustomProbingTable(HashFunction hf, int size = INITIAL_TABLE_SIZE)
         : OpenAddressingHashTable<K, V>(hf, size) {}
 };
 
+// Control byte of one Swiss table slot: a 7-bit hash fragment (0..127)
+// when full, otherwise one of these two negative markers.
+const signed char CTRL_EMPTY = -128;
+const signed char CTRL_DELETED = -2;
+const int GROUP_WIDTH = 16;
+
+// 16 control bytes examined together. Every match returns a bit mask
+// with bit j set when byte j qualifies.
+struct ControlGroup
+{
+#ifdef __SSE2__
+    __m128i ctrl;
+
+    explicit ControlGroup(const signed char *p)
+        : ctrl(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p))) {}
+
+    unsigned match(signed char tag) const
+    {
+        return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(tag), ctrl));
+    }
+
+    // empty or deleted: exactly the bytes with the sign bit set
+    unsigned matchFree() const { return _mm_movemask_epi8(ctrl); }
+#else
+    const signed char *ctrl;
+
+    explicit ControlGroup(const signed char *p) : ctrl(p) {}
+
+    unsigned match(signed char tag) const
+    {
+        unsigned mask = 0;
+        for (int j = 0; j < GROUP_WIDTH; j++)
+            mask |= (unsigned)(ctrl[j] == tag) << j;
+        return mask;
+    }
+
+    unsigned matchFree() const
+    {
+        unsigned mask = 0;
+        for (int j = 0; j < GROUP_WIDTH; j++)
+            mask |= (unsigned)(ctrl[j] < 0) << j;
+        return mask;
+    }
+#endif
+
+    unsigned matchEmpty() const { return match(CTRL_EMPTY); }
+
+    // index of the lowest set bit of a non-zero mask
+    static int lowestBit(unsigned mask)
+    {
+#if defined(__GNUC__)
+        return __builtin_ctz(mask);
+#else
+        int i = 0;
+        while (!(mask & 1))
+        {
+            mask >>= 1;
+            i++;
+        }
+        return i;
+#endif
+    }
+};
+
+// Swiss table style open addressing. A dense array of 1-byte control tags
+// is kept apart from the key/value slots, and a lookup scans the tags of
+// a whole group at once, so it only touches a slot (and compares a
+// string) where the 7-bit fragment already matched. Capacity is a power
+// of two; groups are probed triangularly (+1, +2, +3, ...), which visits
+// every group once. A lookup stops at the first group holding an empty
+// byte.
+//
+// Collisions count insertions that could not settle in their home group;
+// hits count the groups a search probed, a group load being this table's
+// probe as a slot is for the other open addressing tables.
+template <typename K, typename V>
+class SwissTable : public HashTableBase<K, V>
+{
+private:
+    struct Slot
+    {
+        K key;
+        V value;
+        uint64_t hash; // fullHash(key)
+    };
+
+    vector<signed char> ctrl;
+    vector<Slot> slots;
+    int groupMask;
+    int tombstones;
+    HashFunction hashFunc;
+
+    // hashFunc spread over all 64 bits, since hash1 leaves the high ones
+    // clear: the low 7 become the tag, the rest pick the home group
+    uint64_t fullHash(const K &key) const
+    {
+        uint64_t h = hashFunc(key) * 0x9E3779B97F4A7C15ull;
+        return h ^ (h >> 29);
+    }
+
+    static signed char tagOf(uint64_t h) { return (signed char)(h & 0x7f); }
+    int homeGroup(uint64_t h) const { return (int)((h >> 7) & groupMask); }
+
+    int find(const K &key, uint64_t h, int &hits) const
+    {
+        signed char tag = tagOf(h);
+        int g = homeGroup(h);
+        for (int step = 1;; step++)
+        {
+            ControlGroup group(&ctrl[g * GROUP_WIDTH]);
+            hits++;
+            for (unsigned m = group.match(tag); m != 0; m &= m - 1)
+            {
+                int index = g * GROUP_WIDTH + ControlGroup::lowestBit(m);
+                if (slots[index].hash == h && slots[index].key == key)
+                {
+                    return index;
+                }
+            }
+            if (group.matchEmpty() != 0)
+            {
+                return -1;
+            }
+            g = (g + step) & groupMask;
+        }
+    }
+
+    // first empty or deleted slot on h's probe path
+    int findFree(uint64_t h, bool &collided) const
+    {
+        int g = homeGroup(h);
+        collided = false;
+        for (int step = 1;; step++)
+        {
+            unsigned m = ControlGroup(&ctrl[g * GROUP_WIDTH]).matchFree();
+            if (m != 0)
+            {
+                return g * GROUP_WIDTH + ControlGroup::lowestBit(m);
+            }
+            collided = true;
+            g = (g + step) & groupMask;
+        }
+    }
+
+    void place(int index, uint64_t h, K key, V value)
+    {
+        ctrl[index] = tagOf(h);
+        slots[index].key = std::move(key);
+        slots[index].value = std::move(value);
+        slots[index].hash = h;
+    }
+
+    void resize(int newSize)
+    {
+        vector<signed char> oldCtrl = std::move(ctrl);
+        vector<Slot> oldSlots = std::move(slots);
+
+        ctrl.assign(newSize, CTRL_EMPTY);
+        slots.clear();
+        slots.resize(newSize);
+        groupMask = newSize / GROUP_WIDTH - 1;
+        tombstones = 0;
+        this->tableSize = newSize;
+
+        // Move all elements by their stored hashes; keys are known to be
+        // distinct
+        for (size_t i = 0; i < oldCtrl.size(); i++)
+        {
+            if (oldCtrl[i] >= 0)
+            {
+                uint64_t h = oldSlots[i].hash;
+                bool collided;
+                place(findFree(h, collided), h, std::move(oldSlots[i].key), std::move(oldSlots[i].value));
+            }
+        }
+    }
+
+    static int capacityFor(int size)
+    {
+        int capacity = GROUP_WIDTH;
+        while (capacity < size)
+            capacity *= 2;
+        return capacity;
+    }
+
+public:
+    SwissTable(HashFunction hf, int size = INITIAL_TABLE_SIZE)
+        : HashTableBase<K, V>(capacityFor(size)), hashFunc(hf)
+    {
+        ctrl.assign(this->tableSize, CTRL_EMPTY);
+        slots.resize(this->tableSize);
+        groupMask = this->tableSize / GROUP_WIDTH - 1;
+        tombstones = 0;
+    }
+
+    bool insert(const K &key, const V &value) override
+    {
+        uint64_t h = fullHash(key);
+        int hits = 0;
+        if (find(key, h, hits) >= 0) // Key already exists
+        {
+            return false;
+        }
+
+        // keep an empty byte on every probe path so lookups terminate.
+        // Past the limit, double if live slots alone fill more than half
+        // of it; otherwise tombstones are the bulk, and rehashing at the
+        // same size clears them.
+        if ((long long)(this->numElements + tombstones + 1) * SWISS_MAX_LOAD_DEN >
+            (long long)this->tableSize * SWISS_MAX_LOAD_NUM)
+        {
+            bool grow = (long long)(this->numElements + 1) * 2 * SWISS_MAX_LOAD_DEN >
+                        (long long)this->tableSize * SWISS_MAX_LOAD_NUM;
+            resize(grow ? 2 * this->tableSize : this->tableSize);
+            if (grow)
+                this->insertionsSinceExpansion = 0;
+        }
+
+        bool collided;
+        int index = findFree(h, collided);
+        if (ctrl[index] == CTRL_DELETED)
+        {
+            tombstones--;
+        }
+        place(index, h, key, value);
+        this->numElements++;
+        this->insertionsSinceExpansion++;
+        if (collided)
+        {
+            this->collisionCount++;
+        }
+        return true;
+    }
+
+    bool search(const K &key, V &value, int &hits) override
+    {
+        hits = 0;
+        int index = find(key, fullHash(key), hits);
+        if (index < 0)
+        {
+            return false;
+        }
+        value = slots[index].value;
+        return true;
+    }
+
+    bool remove(const K &key) override
+    {
+        int hits = 0;
+        int index = find(key, fullHash(key), hits);
+        if (index < 0)
+        {
+            return false;
+        }
+
+        // A group that still has an empty byte ends every lookup reaching
+        // it, so no probe path runs through it and the slot can go back to
+        // empty; otherwise it has to stay a tombstone.
+        if (ControlGroup(&ctrl[index / GROUP_WIDTH * GROUP_WIDTH]).matchEmpty() != 0)
+        {
+            ctrl[index] = CTRL_EMPTY;
+        }
+        else
+        {
+            ctrl[index] = CTRL_DELETED;
+            tombstones++;
+        }
+        slots[index] = Slot();
+        this->numElements--;
+        this->deletionsSinceCompaction++;
+
+        if (this->tableSize > GROUP_WIDTH &&
+            this->getLoadFactor() < COMPACTION_THRESHOLD &&
+            this->deletionsSinceCompaction >= this->numElements / 2)
+        {
+            resize(this->tableSize / 2);
+            this->deletionsSinceCompaction = 0;
+        }
+
+        return true;
+    }
+};
+
 // Random word generator
 class WordGenerator
 {
@@ -550,6 +1025,46 @@ public:
     }
 };
 
+// Probes and time per search for one table
+struct LookupStats
+{
+    double missHits; // average probes of a search for an absent key
+    double hitNs;    // average time of a search for a present key
+    double missNs;   // average time of a search for an absent key
+};
+
+// Searches every key REPS times; returns the average probes and the
+// time per search of the fastest pass, which is the least disturbed by
+// whatever else the machine is doing.
+template <typename K, typename V>
+void timeSearches(HashTableBase<K, V> *ht, const vector<K> &keys, double &avgHits, double &avgNs)
+{
+    const int REPS = 20;
+    long long totalHits = 0;
+    int found = 0;
+    double best = 0;
+
+    for (int r = 0; r < REPS; r++)
+    {
+        auto start = chrono::steady_clock::now();
+        for (const K &key : keys)
+        {
+            V value;
+            int hits;
+            found += ht->search(key, value, hits);
+            totalHits += hits;
+        }
+        double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+        if (r == 0 || ns < best)
+            best = ns;
+    }
+
+    avgHits = (double)totalHits / ((double)REPS * keys.size());
+    avgNs = best / keys.size();
+    if (found != 0 && found != REPS * (int)keys.size()) // keep the searches observable
+        cerr << "inconsistent lookups\n";
+}
+
 // Performance evaluation
 void evaluatePerformance()
 {
@@ -557,29 +1072,37 @@ void evaluatePerformance()
     const int WORD_LENGTH = 10;
     const int NUM_SEARCHES = 1000;
 
+    // the second half is never inserted, for timing failed searches
     WordGenerator generator;
-    vector<string> words = generator.generateUniqueWords(NUM_WORDS, WORD_LENGTH);
+    vector<string> words = generator.generateUniqueWords(2 * NUM_WORDS, WORD_LENGTH);
+    vector<string> absent(words.begin() + NUM_WORDS, words.end());
+    words.resize(NUM_WORDS);
 
     cout << "Generated " << NUM_WORDS << " unique words of length " << WORD_LENGTH << endl;
     cout << "\nPerformance Evaluation:\n";
-    cout << "====================================================================================\n";
-    cout << setw(25) << "" << setw(30) << "Hash1" << setw(30) << "Hash2" << endl;
+    cout << "==================================================================================================================\n";
+    cout << setw(25) << "" << setw(30) << "Hash1" << setw(30) << "Hash2" << setw(30) << "Hash3" << endl;
     cout << setw(25) << "Method"
+         << setw(15) << "Collisions" << setw(15) << "Avg Hits"
          << setw(15) << "Collisions" << setw(15) << "Avg Hits"
          << setw(15) << "Collisions" << setw(15) << "Avg Hits" << endl;
-    cout << "------------------------------------------------------------------------------------\n";
+    cout << "------------------------------------------------------------------------------------------------------------------\n";
 
     // Test each combination
     vector<pair<string, vector<HashTableBase<string, int> *>>> tests = {
-        {"Chaining Method", {new ChainingHashTable<string, int>(hash1), new ChainingHashTable<string, int>(hash2)}},
-        {"Double Hashing", {new DoubleHashingTable<string, int>(hash1), new DoubleHashingTable<string, int>(hash2)}},
-        {"Custom Probing", {new CustomProbingTable<string, int>(hash1), new CustomProbingTable<string, int>(hash2)}}};
+        {"Chaining Method", {new ChainingHashTable<string, int>(hash1), new ChainingHashTable<string, int>(hash2), new ChainingHashTable<string, int>(hash3)}},
+        {"Double Hashing", {new DoubleHashingTable<string, int>(hash1), new DoubleHashingTable<string, int>(hash2), new DoubleHashingTable<string, int>(hash3)}},
+        {"Custom Probing", {new CustomProbingTable<string, int>(hash1), new CustomProbingTable<string, int>(hash2), new CustomProbingTable<string, int>(hash3)}},
+        {"Swiss Table", {new SwissTable<string, int>(hash1), new SwissTable<string, int>(hash2), new SwissTable<string, int>(hash3)}}};
+
+    vector<vector<LookupStats>> lookups(tests.size());
 
-    for (auto &test : tests)
+    for (size_t t = 0; t < tests.size(); t++)
     {
+        auto &test = tests[t];
         cout << setw(25) << test.first;
 
-        for (int hashVersion = 0; hashVersion < 2; hashVersion++)
+        for (size_t hashVersion = 0; hashVersion < test.second.size(); hashVersion++)
         {
             HashTableBase<string, int> *ht = test.second[hashVersion];
 
@@ -608,13 +1131,45 @@ void evaluatePerformance()
 
             cout << setw(15) << collisions << setw(15) << fixed << setprecision(2) << avgHits;
 
+            LookupStats stats;
+            double hitProbes;
+            timeSearches(ht, words, hitProbes, stats.hitNs);
+            timeSearches(ht, absent, stats.missHits, stats.missNs);
+            lookups[t].push_back(stats);
+
             delete ht;
         }
 
         cout << endl;
     }
 
-    cout << "====================================================================================\n";
+    cout << "==================================================================================================================\n";
+
+    // Hits are probes: a slot for open addressing, a chain node for
+    // chaining, a 16-slot group for the Swiss table. Times are per search,
+    // from the fastest of 20 passes over all present or all absent keys.
+    cout << "\nLookups (" << NUM_WORDS << " present and " << NUM_WORDS << " absent keys):\n";
+    cout << "==================================================================================================================\n";
+    cout << setw(25) << "" << setw(30) << "Hash1" << setw(30) << "Hash2" << setw(30) << "Hash3" << endl;
+    cout << setw(25) << "Method";
+    for (int h = 0; h < 3; h++)
+    {
+        cout << setw(10) << "Miss Hits" << setw(10) << "Hit ns" << setw(10) << "Miss ns";
+    }
+    cout << endl;
+    cout << "------------------------------------------------------------------------------------------------------------------\n";
+    for (size_t t = 0; t < tests.size(); t++)
+    {
+        cout << setw(25) << tests[t].first;
+        for (const LookupStats &stats : lookups[t])
+        {
+            cout << setw(10) << fixed << setprecision(2) << stats.missHits
+                 << setw(10) << setprecision(1) << stats.hitNs
+                 << setw(10) << stats.missNs;
+        }
+        cout << endl;
+    }
+    cout << "==================================================================================================================\n";
 }
 
 int main()
@@ -0,0 +1,40 @@
+#include<cstdio>
+#include<string>
+
+#include "FastIO.h"
+#include "OpStream.h"
+
+using namespace std;
+
+// Converts a text op stream (N, then N `e x` pairs) on stdin into the
+// binary form of OpStream.h, written to the file named on the command
+// line or to stdout. Missing pairs read as `0 0`, as in the drivers. An
+// opcode has one byte in the binary form, so one outside 0..255 is an
+// error rather than being cut down to a different op.
+int main(int argc, char* argv[]) {
+    FILE* f = argc > 1 ? fopen(argv[1], "wb") : stdout;
+    if (!f) {
+        perror(argv[1]);
+        return 1;
+    }
+
+    InBuf in;
+    int N = 0;
+    in >> N;
+    if (N < 0) N = 0;
+    try {
+        OpWriter w(f, N);
+        for (int i = 0; i < N; i++) {
+            int e, x;
+            in >> e >> x;
+            if (e < 0 || e > 255)
+                throw runtime_error("op " + to_string(i + 1) + " has opcode " + to_string(e) + ", outside 0..255");
+            w.put(e, x);
+        }
+        w.finish();
+    } catch (const exception& e) {
+        fprintf(stderr, "%s: %s\n", argc > 1 ? argv[1] : "stdout", e.what());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,179 @@
+#ifndef OP_STREAM_H
+#define OP_STREAM_H
+
+#include<cstdio>
+#include<cstddef>
+#include<cstdint>
+#include<cerrno>
+#include<cstring>
+#include<climits>
+#include<string>
+#include<vector>
+#include<utility>
+#include<stdexcept>
+
+#include<fcntl.h>
+#include<unistd.h>
+#include<sys/mman.h>
+#include<sys/stat.h>
+
+// Packed binary form of an `e x` op stream, so a large stream can be
+// replayed without tokenizing text:
+//
+//   "OPSTRM01", uint64 op count, then per op one opcode byte followed by
+//   the key as a zigzag LEB128 varint (1 byte for |x| < 64, at most 5)
+//
+// OpConvert.cpp turns today's text streams into this form; the drivers
+// read it with `--ops FILE`.
+
+static const char OP_STREAM_MAGIC[8] = {'O', 'P', 'S', 'T', 'R', 'M', '0', '1'};
+
+// Owns the FILE it is given: finish() writes out the buffer and closes
+// it, reporting any failure. A writer destroyed without finish() (say,
+// while an exception unwinds) still closes the file but ignores errors.
+class OpWriter {
+private:
+    static const size_t CAP = 1 << 20;
+    FILE* f;
+    unsigned char buf[CAP];
+    size_t len = 0;
+
+    void flush() {
+        if (fwrite(buf, 1, len, f) != len) throw std::runtime_error("cannot write op stream");
+        len = 0;
+    }
+
+public:
+    // writes the header; exactly `count` put() calls should follow
+    OpWriter(FILE* out, uint64_t count) : f(out) {
+        memcpy(buf, OP_STREAM_MAGIC, sizeof OP_STREAM_MAGIC);
+        memcpy(buf + sizeof OP_STREAM_MAGIC, &count, sizeof count);
+        len = sizeof OP_STREAM_MAGIC + sizeof count;
+    }
+
+    ~OpWriter() {
+        if (f) {
+            fwrite(buf, 1, len, f);
+            fclose(f);
+        }
+    }
+
+    OpWriter(const OpWriter&) = delete;
+    OpWriter& operator=(const OpWriter&) = delete;
+
+    void finish() {
+        flush();
+        FILE* out = f;
+        f = nullptr;
+        if (fclose(out) != 0) throw std::runtime_error("cannot write op stream");
+    }
+
+    // op must be in 0..255; it is stored as one byte
+    void put(int op, int key) {
+        if (len + 6 > CAP) flush();
+        buf[len++] = (unsigned char)op;
+        uint32_t z = ((uint32_t)key << 1) ^ (uint32_t)(key >> 31);
+        while (z >= 0x80) {
+            buf[len++] = (unsigned char)(z | 0x80);
+            z >>= 7;
+        }
+        buf[len++] = (unsigned char)z;
+    }
+};
+
+// Maps a binary op stream read-only and decodes it front to back.
+class OpReader {
+private:
+    void* base = MAP_FAILED;
+    size_t len = 0;
+    const unsigned char* pos = nullptr;
+    const unsigned char* end = nullptr;
+    uint64_t count = 0;
+
+    [[noreturn]] static void fail(const std::string& what, const char* path) {
+        throw std::runtime_error(what + " " + path + (errno ? std::string(": ") + strerror(errno) : ""));
+    }
+
+public:
+    explicit OpReader(const char* path) {
+        int fd = open(path, O_RDONLY);
+        if (fd < 0) fail("cannot open", path);
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            int err = errno;
+            close(fd);
+            errno = err;
+            fail("cannot stat", path);
+        }
+        len = st.st_size;
+        if (len < sizeof OP_STREAM_MAGIC + sizeof count) {
+            close(fd);
+            errno = 0;
+            fail("not an op stream:", path);
+        }
+        base = mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+        int err = errno;
+        close(fd);
+        if (base == MAP_FAILED) {
+            errno = err;
+            fail("cannot map", path);
+        }
+        pos = static_cast<const unsigned char*>(base) + sizeof OP_STREAM_MAGIC;
+        memcpy(&count, pos, sizeof count);
+        pos += sizeof count;
+        end = static_cast<const unsigned char*>(base) + len;
+
+        // every op takes at least two bytes, so a count the file cannot
+        // hold means a damaged header, not a long stream
+        bool magic = memcmp(base, OP_STREAM_MAGIC, sizeof OP_STREAM_MAGIC) == 0;
+        if (!magic || count > (uint64_t)(end - pos) / 2) {
+            munmap(base, len);
+            base = MAP_FAILED;
+            errno = 0;
+            fail(magic ? "op count exceeds the data in" : "not an op stream:", path);
+        }
+        madvise(base, len, MADV_SEQUENTIAL);
+    }
+
+    ~OpReader() {
+        if (base != MAP_FAILED) munmap(base, len);
+    }
+
+    OpReader(const OpReader&) = delete;
+    OpReader& operator=(const OpReader&) = delete;
+
+    uint64_t size() const { return count; }
+
+    // Decodes the next op; false once the data runs out, including in
+    // the middle of a truncated op.
+    bool next(int& op, int& key) {
+        if (pos == end) return false;
+        op = *pos++;
+        uint32_t z = 0;
+        for (int shift = 0; shift < 35; shift += 7) {
+            if (pos == end) return false;
+            unsigned char b = *pos++;
+            z |= (uint32_t)(b & 0x7f) << shift;
+            if (b < 0x80) {
+                key = (int)(z >> 1) ^ -(int)(z & 1);
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+// Reads a whole binary op stream into ops, as the drivers replay it.
+// Throws if the stream is unreadable, has more ops than an int counts,
+// or ends before its header's count.
+inline void readOps(const char* path, std::vector<std::pair<int, int>>& ops) {
+    OpReader bin(path);
+    if (bin.size() > (uint64_t)INT_MAX)
+        throw std::runtime_error(std::string("too many ops in ") + path);
+    ops.resize(bin.size());
+    for (auto& op : ops)
+        if (!bin.next(op.first, op.second))
+            throw std::runtime_error(std::string("op stream ends early: ") + path);
+}
+
+#endif
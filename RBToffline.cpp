@@ -1,315 +1,1483 @@
-#include<iostream>
 #include<vector>
+#include<algorithm>
+#include<string>
+#include<climits>
+#include<cstdint>
+#include<type_traits>
+#include<memory>
+
+#include "FrozenSet.h"
+#include "FastIO.h"
+#include "SetStore.h"
+#include "TreeStats.h"
+#include "OpStream.h"
 
 using namespace std;
 
 enum Color { RED, BLACK };
 
-struct Node {
+// Augmentation policies for RedBlackTree. A policy names the value_type
+// it keeps per subtree, of(key) for a single key, and an associative
+// combine with an identity; combine(a, b) sees the keys of a before those
+// of b, so order-sensitive policies work too. NoAugment keeps nothing.
+struct NoAugment {
+    typedef void value_type;
+};
+
+struct SumAugment {
+    typedef long long value_type;
+    static value_type identity() { return 0; }
+    static value_type of(int key) { return key; }
+    static value_type combine(value_type a, value_type b) { return a + b; }
+};
+
+struct MinAugment {
+    typedef int value_type;
+    static value_type identity() { return INT_MAX; }
+    static value_type of(int key) { return key; }
+    static value_type combine(value_type a, value_type b) { return min(a, b); }
+};
+
+struct MaxAugment {
+    typedef int value_type;
+    static value_type identity() { return INT_MIN; }
+    static value_type of(int key) { return key; }
+    static value_type combine(value_type a, value_type b) { return max(a, b); }
+};
+
+// Policy value of a subtree; empty without an augmentation.
+template <class T>
+struct Summary {
+    T agg;
+};
+
+template <>
+struct Summary<void> {};
+
+// Copies of the key held by a node in multiset mode; empty otherwise.
+template <bool Multi>
+struct Multiplicity {
+    uint32_t count;
+};
+
+template <>
+struct Multiplicity<false> {};
+
+// Nodes live in one pool inside the tree and refer to each other by
+// 32-bit index, with index 0 as the NIL sentinel. The color is the top
+// bit of the size word, so a node of the plain tree takes 20 bytes where
+// the pointer layout took 40 plus its malloc header. In multiset mode the
+// size counts every copy of every key in the subtree.
+template <class Aug = NoAugment, bool Multi = false>
+struct Node : Summary<typename Aug::value_type>, Multiplicity<Multi> {
     int key;
-    Color color;
-    int size;               
-    Node *left, *right, *parent;
-
-    Node(int k = 0): 
-        key(k), 
-        color(RED), 
-        size(1),
-        left(nullptr), 
-        right(nullptr), 
-        parent(nullptr) 
-        {}
-    };
-    
+    uint32_t left, right, parent;
+    uint32_t sizeColor;     // bit 31: color, bits 0-30: subtree size
+};
+static_assert(sizeof(Node<>) == 20, "plain RB node should stay at 20 bytes");
+
+// Besides `size`, which countLess needs, every node keeps Aug's value of
+// its subtree, so aggregate(lo, hi) folds any key range in O(log n).
+// Removed nodes go on a free list threaded through `left` and are reused
+// by later inserts; the pool itself is released with the tree. Whole
+// subtrees cut off by eraseRange or split are queued as they are and
+// taken apart one node per insert, so dropping them costs O(1).
+//
+// With Multi set the tree is a multiset: inserting a present key adds a
+// copy to its node instead of being rejected, remove takes one copy
+// away, and size, countLess, countRange and kth all count copies. The
+// policy value still sees each distinct key once.
+template <class Aug = NoAugment, bool Multi = false>
 class RedBlackTree {
     private:
-    Node* root;
-    Node* NIL;
-    
-    void updateSize(Node* x) {
-            if (x != NIL)
-            x->size = x->left->size + x->right->size + 1;
+    typedef Node<Aug, Multi> NodeT;
+    static constexpr bool augmented = !is_void<typename Aug::value_type>::value;
+    static const uint32_t NIL = 0;
+    static const uint32_t COLOR_BIT = 1u << 31;
+
+    vector<NodeT> pool;
+    uint32_t freeList;
+    vector<uint32_t> doomed;    // roots of detached subtrees awaiting reuse
+    uint32_t root;
+
+    // Finger: the last inserted node and its in-order neighbours (NIL for
+    // either end). A key falling in the gap on either side of it is
+    // linked there directly. finger == NIL when there is none.
+    uint32_t fingerPrev;
+    uint32_t finger;
+    uint32_t fingerNext;
+
+    uint32_t& left(uint32_t x) { return pool[x].left; }
+    uint32_t& right(uint32_t x) { return pool[x].right; }
+    uint32_t& parent(uint32_t x) { return pool[x].parent; }
+    uint32_t left(uint32_t x) const { return pool[x].left; }
+    uint32_t right(uint32_t x) const { return pool[x].right; }
+
+    uint32_t sizeOf(uint32_t x) const { return pool[x].sizeColor & ~COLOR_BIT; }
+    void setSize(uint32_t x, uint32_t n) { pool[x].sizeColor = (pool[x].sizeColor & COLOR_BIT) | n; }
+    uint32_t mult(uint32_t x) const {
+        if constexpr (Multi) return pool[x].count;
+        else return 1;
+    }
+    Color color(uint32_t x) const { return Color(pool[x].sizeColor >> 31); }
+    void setColor(uint32_t x, Color c) { pool[x].sizeColor = (pool[x].sizeColor & ~COLOR_BIT) | (uint32_t)c << 31; }
+
+    // a red leaf for key, unlinked; may move the pool
+    uint32_t alloc(int key) {
+        uint32_t x;
+        if (freeList != NIL) {
+            x = freeList;
+            freeList = pool[x].left;
+        } else if (!doomed.empty()) {
+            x = doomed.back();
+            doomed.pop_back();
+            if (left(x) != NIL) doomed.push_back(left(x));
+            if (right(x) != NIL) doomed.push_back(right(x));
+        } else {
+            x = (uint32_t)pool.size();
+            pool.emplace_back();
+        }
+        NodeT& n = pool[x];
+        n.key = key;
+        n.left = n.right = n.parent = NIL;
+        n.sizeColor = (uint32_t)RED << 31 | 1;
+        if constexpr (Multi) n.count = 1;
+        if constexpr (augmented) n.agg = Aug::of(key);
+        return x;
+    }
+
+    void release(uint32_t x) {
+        pool[x].left = freeList;
+        freeList = x;
+    }
+
+    void updateAgg(uint32_t x) {
+        if constexpr (augmented)
+            pool[x].agg = Aug::combine(Aug::combine(pool[left(x)].agg, Aug::of(keyOf(x))), pool[right(x)].agg);
+    }
+
+    void updateSize(uint32_t x) {
+            if (x != NIL) {
+                setSize(x, sizeOf(left(x)) + sizeOf(right(x)) + mult(x));
+                updateAgg(x);
+            }
         }
         
-    Node* minimum(Node* x) {
-            while (x->left != NIL)
-                x = x->left;
+    uint32_t minimum(uint32_t x) const {
+            while (left(x) != NIL)
+                x = left(x);
             return x;
         }
         
-    void leftRotate(Node* x) {
-        Node* y = x->right;
-        x->right = y->left;
-        if (y->left != NIL)
-        y->left->parent = x;
+    uint32_t maximum(uint32_t x) const {
+        while (right(x) != NIL)
+            x = right(x);
+        return x;
+    }
+
+    uint32_t predecessor(uint32_t x) const {
+        if (left(x) != NIL) return maximum(left(x));
+        uint32_t p = pool[x].parent;
+        while (p != NIL && x == left(p)) {
+            x = p;
+            p = pool[p].parent;
+        }
+        return p;
+    }
+
+    uint32_t successor(uint32_t x) const {
+        if (right(x) != NIL) return minimum(right(x));
+        uint32_t p = pool[x].parent;
+        while (p != NIL && x == right(p)) {
+            x = p;
+            p = pool[p].parent;
+        }
+        return p;
+    }
+
+    void leftRotate(uint32_t x) {
+        TREE_STAT(RB_LEFT_ROTATIONS);
+        uint32_t y = right(x);
+        right(x) = left(y);
+        if (left(y) != NIL)
+        parent(left(y)) = x;
         
-        y->parent = x->parent;
+        parent(y) = parent(x);
         
-        if (x->parent == NIL)
+        if (parent(x) == NIL)
         root = y;
-        else if (x == x->parent->left)
-        x->parent->left = y;
+        else if (x == left(parent(x)))
+        left(parent(x)) = y;
         else
-        x->parent->right = y;
+        right(parent(x)) = y;
         
-        y->left = x;
-        x->parent = y;
+        left(y) = x;
+        parent(x) = y;
         
-        y->size = x->size;
+        setSize(y, sizeOf(x));
+        if constexpr (augmented) pool[y].agg = pool[x].agg;
         updateSize(x);
     }
     
-    void rightRotate(Node* x) {
-        Node* y = x->left;
-        x->left = y->right;
-        if (y->right != NIL)
-        y->right->parent = x;
+    void rightRotate(uint32_t x) {
+        TREE_STAT(RB_RIGHT_ROTATIONS);
+        uint32_t y = left(x);
+        left(x) = right(y);
+        if (right(y) != NIL)
+        parent(right(y)) = x;
         
-        y->parent = x->parent;
+        parent(y) = parent(x);
         
-        if (x->parent == NIL)
+        if (parent(x) == NIL)
         root = y;
-        else if (x == x->parent->right)
-            x->parent->right = y;
+        else if (x == right(parent(x)))
+            right(parent(x)) = y;
         else
-            x->parent->left = y;
+            left(parent(x)) = y;
 
-        y->right = x;
-        x->parent = y;
+        right(y) = x;
+        parent(x) = y;
 
-        y->size = x->size;
+        setSize(y, sizeOf(x));
+        if constexpr (augmented) pool[y].agg = pool[x].agg;
         updateSize(x);
     }
 
-    void insertFix(Node* z) {
-        while (z->parent->color == RED) {
-            if (z->parent == z->parent->parent->left) {
-                Node* y = z->parent->parent->right;
-                if (y->color == RED) {
-                    z->parent->color = BLACK;
-                    y->color = BLACK;
-                    z->parent->parent->color = RED;
-                    z = z->parent->parent;
+    // Returns whether the black height grew, which happens when a red
+    // pushed up to the root is blackened there.
+    bool insertFix(uint32_t z) {
+        while (color(parent(z)) == RED) {
+            TREE_STAT(RB_INSERT_FIX_LOOPS);
+            uint32_t g = parent(parent(z));
+            if (parent(z) == left(g)) {
+                uint32_t y = right(g);
+                if (color(y) == RED) {
+                    setColor(parent(z), BLACK);
+                    setColor(y, BLACK);
+                    setColor(g, RED);
+                    z = g;
                 } else {
-                    if (z == z->parent->right) {
-                        z = z->parent;
+                    if (z == right(parent(z))) {
+                        z = parent(z);
                         leftRotate(z);
                     }
-                    z->parent->color = BLACK;
-                    z->parent->parent->color = RED;
-                    rightRotate(z->parent->parent);
+                    setColor(parent(z), BLACK);
+                    setColor(parent(parent(z)), RED);
+                    rightRotate(parent(parent(z)));
                 }
             } else {
-                Node* y = z->parent->parent->left;
-                if (y->color == RED) {
-                    z->parent->color = BLACK;
-                    y->color = BLACK;
-                    z->parent->parent->color = RED;
-                    z = z->parent->parent;
+                uint32_t y = left(g);
+                if (color(y) == RED) {
+                    setColor(parent(z), BLACK);
+                    setColor(y, BLACK);
+                    setColor(g, RED);
+                    z = g;
                 } else {
-                    if (z == z->parent->left) {
-                        z = z->parent;
+                    if (z == left(parent(z))) {
+                        z = parent(z);
                         rightRotate(z);
                     }
-                    z->parent->color = BLACK;
-                    z->parent->parent->color = RED;
-                    leftRotate(z->parent->parent);
+                    setColor(parent(z), BLACK);
+                    setColor(parent(parent(z)), RED);
+                    leftRotate(parent(parent(z)));
                 }
             }
         }
-        root->color = BLACK;
+        bool grew = color(root) == RED;
+        setColor(root, BLACK);
+        return grew;
+    }
+
+
+    // Hangs a new node for key in the gap between the adjacent nodes
+    // lo < key < hi (NIL standing for either end). Exactly one of
+    // lo->right and hi->left is free, so no descent is needed; the sizes
+    // and policy values above still take a walk up the parent links. They
+    // are only adjusted once the update is known to happen, so a rejected
+    // insert leaves countLess untouched.
+    uint32_t link(uint32_t lo, uint32_t hi, int key) {
+        uint32_t z = alloc(key);
+        if (lo != NIL && right(lo) == NIL) {
+            parent(z) = lo;
+            right(lo) = z;
+        } else if (hi != NIL) {
+            parent(z) = hi;
+            left(hi) = z;
+        } else {
+            parent(z) = NIL;
+            root = z;
+        }
+
+        for (uint32_t p = parent(z); p != NIL; p = parent(p)) {
+            pool[p].sizeColor++;
+            updateAgg(p);
+        }
+
+        insertFix(z);
+        fingerPrev = lo;
+        finger = z;
+        fingerNext = hi;
+        return z;
+    }
+
+    // one more copy of the key at x, counted in every size above it
+    void addCopy(uint32_t x) {
+        pool[x].count++;
+        for (; x != NIL; x = parent(x)) pool[x].sizeColor++;
     }
 
+    // Returns the node holding key, linking a new one if needed. The gaps
+    // next to the finger are tried before a descent from the root, which
+    // makes runs of increasing, decreasing or clustered keys skip the
+    // descent.
+    uint32_t place(int key, bool& inserted) {
+        inserted = true;
+        if (finger != NIL) {
+            if (key > keyOf(finger) && (fingerNext == NIL || key < keyOf(fingerNext)))
+                return link(finger, fingerNext, key);
+            if (key < keyOf(finger) && (fingerPrev == NIL || key > keyOf(fingerPrev)))
+                return link(fingerPrev, finger, key);
+        }
+
+        uint32_t lo = NIL;
+        uint32_t hi = NIL;
+        uint32_t x = root;
+        while (x != NIL) {
+            if (key == keyOf(x)) {
+                inserted = false;
+                return x;
+            }
+            if (key < keyOf(x)) {
+                hi = x;
+                x = left(x);
+            } else {
+                lo = x;
+                x = right(x);
+            }
+        }
+        return link(lo, hi, key);
+    }
 
-    void transplant(Node* u, Node* v) {
-        if (u->parent == NIL)
+    void transplant(uint32_t u, uint32_t v) {
+        if (parent(u) == NIL)
             root = v;
-        else if (u == u->parent->left)
-            u->parent->left = v;
+        else if (u == left(parent(u)))
+            left(parent(u)) = v;
         else
-            u->parent->right = v;
-        v->parent = u->parent;
-    }
-
-    void deleteFix(Node* x) {
-        while (x != root && x->color == BLACK) {
-            if (x == x->parent->left) {
-                Node* w = x->parent->right;
-                if (w->color == RED) {
-                    w->color = BLACK;
-                    x->parent->color = RED;
-                    leftRotate(x->parent);
-                    w = x->parent->right;
+            right(parent(u)) = v;
+        parent(v) = parent(u);
+    }
+
+    void deleteFix(uint32_t x) {
+        while (x != root && color(x) == BLACK) {
+            TREE_STAT(RB_DELETE_FIX_LOOPS);
+            if (x == left(parent(x))) {
+                uint32_t w = right(parent(x));
+                if (color(w) == RED) {
+                    setColor(w, BLACK);
+                    setColor(parent(x), RED);
+                    leftRotate(parent(x));
+                    w = right(parent(x));
                 }
-                if (w->left->color == BLACK && w->right->color == BLACK) {
-                    w->color = RED;
-                    x = x->parent;
+                if (color(left(w)) == BLACK && color(right(w)) == BLACK) {
+                    setColor(w, RED);
+                    x = parent(x);
                 } else {
-                    if (w->right->color == BLACK) {
-                        w->left->color = BLACK;
-                        w->color = RED;
+                    if (color(right(w)) == BLACK) {
+                        setColor(left(w), BLACK);
+                        setColor(w, RED);
                         rightRotate(w);
-                        w = x->parent->right;
+                        w = right(parent(x));
                     }
-                    w->color = x->parent->color;
-                    x->parent->color = BLACK;
-                    w->right->color = BLACK;
-                    leftRotate(x->parent);
+                    setColor(w, color(parent(x)));
+                    setColor(parent(x), BLACK);
+                    setColor(right(w), BLACK);
+                    leftRotate(parent(x));
                     x = root;
                 }
             } else {
-                Node* w = x->parent->left;
-                if (w->color == RED) {
-                    w->color = BLACK;
-                    x->parent->color = RED;
-                    rightRotate(x->parent);
-                    w = x->parent->left;
+                uint32_t w = left(parent(x));
+                if (color(w) == RED) {
+                    setColor(w, BLACK);
+                    setColor(parent(x), RED);
+                    rightRotate(parent(x));
+                    w = left(parent(x));
                 }
-                if (w->right->color == BLACK && w->left->color == BLACK) {
-                    w->color = RED;
-                    x = x->parent;
+                if (color(right(w)) == BLACK && color(left(w)) == BLACK) {
+                    setColor(w, RED);
+                    x = parent(x);
                 } else {
-                    if (w->left->color == BLACK) {
-                        w->right->color = BLACK;
-                        w->color = RED;
+                    if (color(left(w)) == BLACK) {
+                        setColor(right(w), BLACK);
+                        setColor(w, RED);
                         leftRotate(w);
-                        w = x->parent->left;
+                        w = left(parent(x));
                     }
-                    w->color = x->parent->color;
-                    x->parent->color = BLACK;
-                    w->left->color = BLACK;
-                    rightRotate(x->parent);
+                    setColor(w, color(parent(x)));
+                    setColor(parent(x), BLACK);
+                    setColor(left(w), BLACK);
+                    rightRotate(parent(x));
                     x = root;
                 }
             }
         }
-        x->color = BLACK;
+        setColor(x, BLACK);
+    }
+
+    // Takes z out of the tree; the node itself is left to the caller.
+    void unlink(uint32_t z) {
+        // the node that physically leaves the tree is z itself, or its
+        // successor when z has two children. In a multiset the successor
+        // carries its copies up past the nodes in between, so there the
+        // sizes are recomputed after the splice instead.
+        uint32_t gone = (left(z) == NIL || right(z) == NIL) ? z : minimum(right(z));
+        if constexpr (!Multi)
+            for (uint32_t p = parent(gone); p != NIL; p = parent(p)) pool[p].sizeColor--;
+
+        uint32_t y = z;
+        uint32_t x;
+        Color yOriginal = color(y);
+
+        if (left(z) == NIL) {
+            x = right(z);
+            transplant(z, right(z));
+        } else if (right(z) == NIL) {
+            x = left(z);
+            transplant(z, left(z));
+        } else {
+            y = minimum(right(z));
+            yOriginal = color(y);
+            x = right(y);
+
+            if (parent(y) == z)
+                parent(x) = y;
+            else {
+                transplant(y, right(y));
+                right(y) = right(z);
+                parent(right(y)) = y;
+            }
+
+            transplant(z, y);
+            left(y) = left(z);
+            parent(left(y)) = y;
+            setColor(y, color(z));
+            updateSize(y);
+        }
+
+        // parent(x) is now the lowest node whose subtree lost a key
+        if constexpr (Multi)
+            for (uint32_t p = parent(x); p != NIL; p = parent(p)) updateSize(p);
+        else if constexpr (augmented)
+            for (uint32_t p = parent(x); p != NIL; p = parent(p)) updateAgg(p);
+
+        if (yOriginal == BLACK)
+            deleteFix(x);
+    }
+
+    // ---- split/join; trees here are detached subtrees of this pool with
+    // a black root and a NIL parent, passed with their black height ----
+
+    int blackHeight(uint32_t x) const {
+        int h = 0;
+        for (; x != NIL; x = left(x)) h += color(x) == BLACK;
+        return h;
+    }
+
+    // Cuts x loose as a tree of its own; returns 1 if blackening its root
+    // added a level of black height.
+    int detach(uint32_t x) {
+        if (x == NIL) return 0;
+        parent(x) = NIL;
+        if (color(x) == BLACK) return 0;
+        setColor(x, BLACK);
+        return 1;
+    }
+
+    // Joins l < k < r into one tree, k being a spare node. The shorter
+    // tree hangs off the spine of the taller one where the black heights
+    // meet, k red on top of it, and insertFix repairs the rest. O(|hl -
+    // hr| + 1); the result's black height comes back in h.
+    uint32_t join(uint32_t l, int hl, uint32_t k, uint32_t r, int hr, int& h) {
+        if (hl == hr) {
+            left(k) = l;
+            right(k) = r;
+            parent(k) = NIL;
+            if (l != NIL) parent(l) = k;
+            if (r != NIL) parent(r) = k;
+            setColor(k, BLACK);
+            updateSize(k);
+            h = hl + 1;
+            return k;
+        }
+
+        bool intoLeft = hl > hr;
+        uint32_t c = intoLeft ? l : r;
+        uint32_t p = NIL;
+        int hc = intoLeft ? hl : hr;
+        int target = intoLeft ? hr : hl;
+        while (color(c) == RED || hc != target) {
+            hc -= color(c) == BLACK;
+            p = c;
+            c = intoLeft ? right(c) : left(c);
+        }
+        if (intoLeft) {
+            left(k) = c;
+            right(k) = r;
+            right(p) = k;
+        } else {
+            left(k) = l;
+            right(k) = c;
+            left(p) = k;
+        }
+        if (left(k) != NIL) parent(left(k)) = k;
+        if (right(k) != NIL) parent(right(k)) = k;
+        parent(k) = p;
+        setColor(k, RED);
+        for (uint32_t x = k; x != NIL; x = parent(x)) updateSize(x);
+
+        root = intoLeft ? l : r;
+        h = (intoLeft ? hl : hr) + insertFix(k);
+        return root;
+    }
+
+    // joins l < r without a spare node by borrowing r's minimum
+    uint32_t join2(uint32_t l, int hl, uint32_t r, int hr, int& h) {
+        if (l == NIL) {
+            h = hr;
+            return r;
+        }
+        if (r == NIL) {
+            h = hl;
+            return l;
+        }
+        root = r;
+        uint32_t k = minimum(r);
+        unlink(k);
+        r = root;
+        return join(l, hl, k, r, blackHeight(r), h);
+    }
+
+    // Splits t around key into l (< key) and r (> key); the node holding
+    // key, if any, comes back detached in `found`. The joins on the way
+    // up telescope, so the whole split is O(log n).
+    void split(uint32_t t, int ht, int key, uint32_t& l, int& hl, uint32_t& found, uint32_t& r, int& hr) {
+        if (t == NIL) {
+            l = found = r = NIL;
+            hl = hr = 0;
+            return;
+        }
+        int hc = ht - (color(t) == BLACK);
+        uint32_t tl = left(t), tr = right(t);
+        int htl = hc + detach(tl), htr = hc + detach(tr);
+        if (key < keyOf(t)) {
+            split(tl, htl, key, l, hl, found, r, hr);
+            r = join(r, hr, t, tr, htr, hr);
+        } else if (key > keyOf(t)) {
+            split(tr, htr, key, l, hl, found, r, hr);
+            l = join(tl, htl, t, l, hl, hl);
+        } else {
+            l = tl;
+            hl = htl;
+            found = t;
+            r = tr;
+            hr = htr;
+        }
+    }
+
+    // keys[lo, hi) as a balanced subtree, its nodes allocated in key
+    // order; nodes at depth redDepth and below are red
+    uint32_t build(const int* keys, size_t lo, size_t hi, int depth, int redDepth) {
+        if (lo == hi) return NIL;
+        size_t mid = lo + (hi - lo) / 2;
+        uint32_t l = build(keys, lo, mid, depth + 1, redDepth);
+        uint32_t x = alloc(keys[mid]);
+        uint32_t r = build(keys, mid + 1, hi, depth + 1, redDepth);
+        left(x) = l;
+        right(x) = r;
+        if (l != NIL) parent(l) = x;
+        if (r != NIL) parent(r) = x;
+        setColor(x, depth >= redDepth ? RED : BLACK);
+        updateSize(x);
+        return x;
+    }
+
+    // copies the subtree t of another tree into this pool
+    uint32_t import(const RedBlackTree& other, uint32_t t) {
+        if (t == NIL) return NIL;
+        uint32_t l = import(other, other.left(t));
+        uint32_t r = import(other, other.right(t));
+        uint32_t n = alloc(0);
+        pool[n] = other.pool[t];
+        pool[n].left = l;
+        pool[n].right = r;
+        pool[n].parent = NIL;
+        if (l != NIL) parent(l) = n;
+        if (r != NIL) parent(r) = n;
+        return n;
     }
 
 public:
-    RedBlackTree() {
-        NIL = new Node();
-        NIL->color = BLACK;
-        NIL->size = 0;
-        NIL->left = NIL->right = NIL->parent = NIL;
+    RedBlackTree() { clear(); }
+
+    void clear() {
+        // slot 0 is NIL: black, size 0
+        pool.assign(1, NodeT());
+        NodeT& nil = pool[NIL];
+        nil.key = 0;
+        nil.left = nil.right = nil.parent = NIL;
+        nil.sizeColor = (uint32_t)BLACK << 31;
+        if constexpr (augmented) nil.agg = Aug::identity();
+        freeList = NIL;
+        doomed.clear();
         root = NIL;
+        fingerPrev = finger = fingerNext = NIL;
     }
 
-    bool search(int key) {
-        Node* cur = root;
+    // key held by a node handle from lowerBound or insertHint
+    int keyOf(uint32_t x) const { return pool[x].key; }
+
+    bool search(int key) const {
+        TreePath probe;
+        uint32_t cur = root;
         while (cur != NIL) {
-            if (key == cur->key) return true;
-            if (key < cur->key) cur = cur->left;
-            else cur = cur->right;
+            probe.step();
+            if (key == keyOf(cur)) return true;
+            if (key < keyOf(cur)) cur = left(cur);
+            else cur = right(cur);
         }
         return false;
     }
 
+    // false if key was already present; a multiset still adds the copy
     bool insert(int key) {
-        Node* z = new Node(key);
-        z->left = z->right = z->parent = NIL;
+        bool inserted;
+        uint32_t x = place(key, inserted);
+        if constexpr (Multi)
+            if (!inserted) addCopy(x);
+        return inserted;
+    }
 
-        Node* y = NIL;
-        Node* x = root;
+    // copies of key in the tree: 0 or 1 unless Multi
+    int count(int key) const {
+        uint32_t cur = root;
+        while (cur != NIL && keyOf(cur) != key)
+            cur = key < keyOf(cur) ? left(cur) : right(cur);
+        return cur == NIL ? 0 : (int)mult(cur);
+    }
 
-        while (x != NIL) {
-            y = x;
-            x->size++;
-            if (key == x->key) return false;
-            if (key < x->key) x = x->left;
-            else x = x->right;
+    // first node with a key >= key, or 0 if there is none; usable as a
+    // hint until that node is removed
+    uint32_t lowerBound(int key) const {
+        uint32_t res = NIL;
+        uint32_t cur = root;
+        while (cur != NIL) {
+            if (key <= keyOf(cur)) {
+                res = cur;
+                cur = left(cur);
+            } else {
+                cur = right(cur);
+            }
         }
+        return res;
+    }
 
-        z->parent = y;
-        if (y == NIL) root = z;
-        else if (key < y->key) y->left = z;
-        else y->right = z;
-
-        insertFix(z);
-        return true;
+    // Inserts key next to hint, a node holding a neighbouring key (0
+    // standing for the end of the tree), and returns the node holding key.
+    // If key belongs right before or right after hint, it is linked there
+    // without a descent from the root; otherwise this is a plain insert.
+    uint32_t insertHint(uint32_t hint, int key) {
+        uint32_t lo;
+        uint32_t hi;
+        if (hint == NIL) {
+            lo = maximum(root);
+            hi = NIL;
+        } else if (key == keyOf(hint)) {
+            if constexpr (Multi) addCopy(hint);
+            return hint;
+        } else if (key < keyOf(hint)) {
+            lo = predecessor(hint);
+            hi = hint;
+        } else {
+            lo = hint;
+            hi = successor(hint);
+        }
+        if ((lo == NIL || keyOf(lo) < key) && (hi == NIL || key < keyOf(hi)))
+            return link(lo, hi, key);
+        bool inserted;
+        uint32_t x = place(key, inserted);
+        if constexpr (Multi)
+            if (!inserted) addCopy(x);
+        return x;
     }
 
     bool remove(int key) {
-        Node* z = root;
-        while (z != NIL && z->key != key) {
-            z->size--;
-            if (key < z->key) z = z->left;
-            else z = z->right;
+        uint32_t z = root;
+        while (z != NIL && keyOf(z) != key) {
+            if (key < keyOf(z)) z = left(z);
+            else z = right(z);
         }
         if (z == NIL) return false;
+        if constexpr (Multi) {
+            if (pool[z].count > 1) {
+                pool[z].count--;
+                for (uint32_t p = z; p != NIL; p = parent(p)) pool[p].sizeColor--;
+                return true;
+            }
+        }
+        if (z == fingerPrev || z == finger || z == fingerNext)
+            fingerPrev = finger = fingerNext = NIL;
 
-        Node* y = z;
-        Node* x;
-        Color yOriginal = y->color;
+        unlink(z);
+        release(z);
+        return true;
+    }
 
-        if (z->left == NIL) {
-            x = z->right;
-            transplant(z, z->right);
-        } else if (z->right == NIL) {
-            x = z->left;
-            transplant(z, z->left);
-        } else {
-            y = minimum(z->right);
-            yOriginal = y->color;
-            x = y->right;
+    // Removes every key in [lo, hi) (all copies, in a multiset) and
+    // returns how many went. Two splits cut the range out as one subtree
+    // and a join closes the gap, so this is O(log n) however many keys
+    // leave; their nodes are recycled lazily by later inserts.
+    int eraseRange(int lo, int hi) {
+        if (lo >= hi || root == NIL) return 0;
+        int before = size();
+        uint32_t l, first, rest, mid, last, r;
+        int hl, hrest, hmid, hr, h;
+        split(root, blackHeight(root), lo, l, hl, first, rest, hrest);
+        split(rest, hrest, hi, mid, hmid, last, r, hr);
+        if (first != NIL) release(first);
+        if (last != NIL) r = join(NIL, 0, last, r, hr, hr);   // hi stays
+        if (mid != NIL) doomed.push_back(mid);
+        root = join2(l, hl, r, hr, h);
+        fingerPrev = finger = fingerNext = NIL;
+        return before - size();
+    }
+
+    // Leaves the keys < key in this tree and moves the keys > key into
+    // `greater` (into its pool, so O(log n) plus the keys moved). Returns
+    // whether key was present; it is dropped.
+    bool split(int key, RedBlackTree& greater) {
+        uint32_t l, found, r;
+        int hl, hr;
+        split(root, blackHeight(root), key, l, hl, found, r, hr);
+        greater.clear();
+        greater.root = greater.import(*this, r);
+        if (r != NIL) doomed.push_back(r);
+        if (found != NIL) release(found);
+        root = l;
+        fingerPrev = finger = fingerNext = NIL;
+        return found != NIL;
+    }
+
+    // Concatenates L, key, R where every key of L < key < every key of R.
+    // R's nodes are copied into L's pool; the combine itself is
+    // O(|bh(L) - bh(R)| + 1).
+    static RedBlackTree join(RedBlackTree&& L, int key, RedBlackTree&& R) {
+        RedBlackTree t = move(L);
+        L.clear();
+        uint32_t r = t.import(R, R.root);
+        uint32_t k = t.alloc(key);
+        int h;
+        t.root = t.join(t.root, t.blackHeight(t.root), k, r, t.blackHeight(r), h);
+        t.fingerPrev = t.finger = t.fingerNext = NIL;
+        R.clear();
+        return t;
+    }
+
+    int size() const { return (int)sizeOf(root); }
+
+    // Replaces the contents with keys[0, n), which must be strictly
+    // increasing, in O(n). Every level of the balanced shape is full but
+    // the last, which is coloured red, so all paths carry the same
+    // number of black nodes.
+    void bulkLoad(const int* keys, size_t n) {
+        clear();
+        pool.reserve(n + 1);
+        int full = 0;
+        while (((size_t)2 << full) - 1 <= n) full++;
+        root = build(keys, 0, n, 0, full);
+    }
+
+    // calls f(key) for every distinct key in increasing order
+    template <class F>
+    void forEach(F f) const {
+        vector<uint32_t> stack;
+        uint32_t cur = root;
+        while (cur != NIL || !stack.empty()) {
+            while (cur != NIL) {
+                stack.push_back(cur);
+                cur = left(cur);
+            }
+            cur = stack.back();
+            stack.pop_back();
+            f(keyOf(cur));
+            cur = right(cur);
+        }
+    }
+
+    // read-only Eytzinger copy of the current keys, O(n)
+    FrozenSet freeze() const {
+        static_assert(!Multi, "a FrozenSet holds distinct keys");
+        vector<int> sorted;
+        sorted.reserve(sizeOf(root));
+        forEach([&](int key) { sorted.push_back(key); });
+        return FrozenSet(sorted);
+    }
 
-            if (y->parent == z)
-                x->parent = y;
+    int countLess(int key) const {
+        int res = 0;
+        uint32_t cur = root;
+        while (cur != NIL) {
+            if (key <= keyOf(cur))
+                cur = left(cur);
             else {
-                transplant(y, y->right);
-                y->right = z->right;
-                y->right->parent = y;
+                res += sizeOf(left(cur)) + mult(cur);
+                cur = right(cur);
             }
+        }
+        return res;
+    }
 
-            transplant(z, y);
-            y->left = z->left;
-            y->left->parent = y;
-            y->color = z->color;
-            updateSize(y);
+    // number of keys (copies, in multiset mode) in [lo, hi)
+    int countRange(int lo, int hi) const {
+        return lo < hi ? countLess(hi) - countLess(lo) : 0;
+    }
+
+    // The k-th smallest key, counting from 0 and counting copies, so
+    // kth(countLess(x)) == x for a present x; false if k is out of range.
+    bool kth(int k, int& key) const {
+        if (k < 0 || k >= size()) return false;
+        uint32_t cur = root;
+        while (true) {
+            int l = (int)sizeOf(left(cur));
+            if (k < l) {
+                cur = left(cur);
+            } else if (k < l + (int)mult(cur)) {
+                key = keyOf(cur);
+                return true;
+            } else {
+                k -= l + (int)mult(cur);
+                cur = right(cur);
+            }
         }
+    }
 
-        if (yOriginal == BLACK)
-            deleteFix(x);
+    // Aug's combine over the keys in [lo, hi), in key order; identity if
+    // there are none. Below the node where the searches for lo and hi
+    // part, each side adds whole subtrees along one path.
+    typename Aug::value_type aggregate(int lo, int hi) const {
+        static_assert(augmented, "aggregate needs an augmentation policy");
+        uint32_t x = root;
+        while (x != NIL && (keyOf(x) < lo || keyOf(x) >= hi))
+            x = keyOf(x) < lo ? right(x) : left(x);
+        if (x == NIL) return Aug::identity();
+
+        typename Aug::value_type lsum = Aug::identity(), rsum = Aug::identity();
+        for (uint32_t c = left(x); c != NIL;) {
+            if (keyOf(c) >= lo) {
+                lsum = Aug::combine(Aug::combine(Aug::of(keyOf(c)), pool[right(c)].agg), lsum);
+                c = left(c);
+            } else {
+                c = right(c);
+            }
+        }
+        for (uint32_t c = right(x); c != NIL;) {
+            if (keyOf(c) < hi) {
+                rsum = Aug::combine(rsum, Aug::combine(pool[left(c)].agg, Aug::of(keyOf(c))));
+                c = right(c);
+            } else {
+                c = left(c);
+            }
+        }
+        return Aug::combine(Aug::combine(lsum, Aug::of(keyOf(x))), rsum);
+    }
+};
+
+// B+tree over int keys with the same insert/remove/search/countLess
+// contract as RedBlackTree. Every node is four cache lines: a leaf holds
+// up to 60 sorted keys and a link to the next leaf, an inner node up to
+// 15 separators (one line), 16 per-child key counts (one line) and 16
+// child pointers (two lines). A lookup touches about two lines per level
+// over log_16 of the leaf count levels, and a key costs 4-6 bytes at the
+// usual 2/3 fill instead of a 40-byte red-black node.
+class BPlusTree {
+private:
+    static const int LEAF_CAP = 60;
+    static const int INNER_CAP = 15;            // separators; children = INNER_CAP + 1
+    static const int LEAF_MIN = LEAF_CAP / 2;
+    static const int INNER_MIN = INNER_CAP / 2;
+
+    struct BNode {
+        int n;                                  // keys held
+    };
+
+    struct alignas(64) Leaf : BNode {
+        Leaf* next;
+        int keys[LEAF_CAP];
+    };
+
+    // child[i] holds the keys in [keys[i-1], keys[i]); counts[i] is how many
+    struct alignas(64) Inner : BNode {
+        int keys[INNER_CAP];
+        int counts[INNER_CAP + 1];
+        BNode* child[INNER_CAP + 1];
+    };
+
+    static_assert(sizeof(Leaf) == 256 && sizeof(Inner) == 256, "B+tree nodes should be four cache lines");
+
+    BNode* root;
+    Leaf* head;                                 // leftmost leaf; merges never free it
+    int height = 0;                             // inner levels above the leaves
+    int total = 0;
+
+    // Plain counting loops over a node's keys; they have no early exit,
+    // so they compile to compares and adds the CPU never mispredicts.
+    static int countBelow(const int* keys, int n, int key) {
+        int i = 0;
+        for (int j = 0; j < n; j++) i += keys[j] < key;
+        return i;
+    }
+
+    static int countUpTo(const int* keys, int n, int key) {
+        int i = 0;
+        for (int j = 0; j < n; j++) i += keys[j] <= key;
+        return i;
+    }
+
+    static int weight(const BNode* x, int h) {
+        if (h == 0) return x->n;
+        const Inner* in = static_cast<const Inner*>(x);
+        int w = 0;
+        for (int i = 0; i <= in->n; i++) w += in->counts[i];
+        return w;
+    }
+
+    // first leaf that may hold key
+    Leaf* leafFor(int key) const {
+        BNode* x = root;
+        for (int h = height; h > 0; h--) {
+            Inner* in = static_cast<Inner*>(x);
+            x = in->child[countUpTo(in->keys, in->n, key)];
+        }
+        return static_cast<Leaf*>(x);
+    }
+
+    // Inserts key under x (h levels above the leaves). If x overflows it
+    // is split, and the new right half and the first key it covers come
+    // back in split/sep. Returns whether key was new.
+    bool insertRec(BNode* x, int h, int key, BNode*& split, int& sep) {
+        split = nullptr;
+        if (h == 0) {
+            Leaf* l = static_cast<Leaf*>(x);
+            int i = countBelow(l->keys, l->n, key);
+            if (i < l->n && l->keys[i] == key) return false;
+            if (l->n == LEAF_CAP) {
+                Leaf* r = new Leaf;
+                int half = LEAF_CAP / 2;
+                r->n = LEAF_CAP - half;
+                copy(l->keys + half, l->keys + LEAF_CAP, r->keys);
+                l->n = half;
+                r->next = l->next;
+                l->next = r;
+                split = r;
+                if (i > half) {
+                    l = r;
+                    i -= half;
+                }
+            }
+            copy_backward(l->keys + i, l->keys + l->n, l->keys + l->n + 1);
+            l->keys[i] = key;
+            l->n++;
+            if (split) sep = static_cast<Leaf*>(split)->keys[0];
+            return true;
+        }
+
+        Inner* in = static_cast<Inner*>(x);
+        int c = countUpTo(in->keys, in->n, key);
+        BNode* cs;
+        int csep;
+        if (!insertRec(in->child[c], h - 1, key, cs, csep)) return false;
+        in->counts[c]++;
+        if (!cs) return true;
+
+        int w = weight(cs, h - 1);
+        int keys[INNER_CAP + 1], counts[INNER_CAP + 2];
+        BNode* child[INNER_CAP + 2];
+        int n = in->n;
+        copy(in->keys, in->keys + c, keys);
+        keys[c] = csep;
+        copy(in->keys + c, in->keys + n, keys + c + 1);
+        copy(in->child, in->child + c + 1, child);
+        child[c + 1] = cs;
+        copy(in->child + c + 1, in->child + n + 1, child + c + 2);
+        copy(in->counts, in->counts + c + 1, counts);
+        counts[c] -= w;
+        counts[c + 1] = w;
+        copy(in->counts + c + 1, in->counts + n + 1, counts + c + 2);
+        n++;
+
+        if (n <= INNER_CAP) {
+            fill(in, keys, counts, child, 0, n);
+            return true;
+        }
+        // 16 separators: the left half keeps 8, the ninth moves up
+        int mid = n / 2;
+        Inner* r = new Inner;
+        fill(in, keys, counts, child, 0, mid);
+        fill(r, keys, counts, child, mid + 1, n);
+        split = r;
+        sep = keys[mid];
+        return true;
+    }
+
+    // x takes separators [lo, hi) and the children around them
+    static void fill(Inner* x, const int* keys, const int* counts, BNode* const* child, int lo, int hi) {
+        x->n = hi - lo;
+        copy(keys + lo, keys + hi, x->keys);
+        copy(counts + lo, counts + hi + 1, x->counts);
+        copy(child + lo, child + hi + 1, x->child);
+    }
+
+    bool removeRec(BNode* x, int h, int key) {
+        if (h == 0) {
+            Leaf* l = static_cast<Leaf*>(x);
+            int i = countBelow(l->keys, l->n, key);
+            if (i == l->n || l->keys[i] != key) return false;
+            copy(l->keys + i + 1, l->keys + l->n, l->keys + i);
+            l->n--;
+            return true;
+        }
+
+        Inner* in = static_cast<Inner*>(x);
+        int c = countUpTo(in->keys, in->n, key);
+        if (!removeRec(in->child[c], h - 1, key)) return false;
+        in->counts[c]--;
+        if (in->child[c]->n < (h == 1 ? LEAF_MIN : INNER_MIN))
+            rebalanceChildren(in, c > 0 ? c - 1 : c, h - 1);
+        return true;
+    }
+
+    // Children i and i + 1 of in (h levels above the leaves) are pooled:
+    // they merge into child i if that fits, otherwise the keys are split
+    // evenly between them and the separator is renewed.
+    void rebalanceChildren(Inner* in, int i, int h) {
+        BNode* a = in->child[i];
+        BNode* b = in->child[i + 1];
+        bool merge;
+
+        if (h == 0) {
+            Leaf* la = static_cast<Leaf*>(a);
+            Leaf* lb = static_cast<Leaf*>(b);
+            int keys[2 * LEAF_CAP];
+            int n = la->n + lb->n;
+            copy(la->keys, la->keys + la->n, keys);
+            copy(lb->keys, lb->keys + lb->n, keys + la->n);
+            merge = n <= LEAF_CAP;
+            int left = merge ? n : n / 2;
+            la->n = left;
+            copy(keys, keys + left, la->keys);
+            if (merge) {
+                la->next = lb->next;
+                delete lb;
+            } else {
+                lb->n = n - left;
+                copy(keys + left, keys + n, lb->keys);
+                in->keys[i] = lb->keys[0];
+                in->counts[i] = la->n;
+                in->counts[i + 1] = lb->n;
+            }
+        } else {
+            Inner* ia = static_cast<Inner*>(a);
+            Inner* ib = static_cast<Inner*>(b);
+            int keys[2 * INNER_CAP + 1], counts[2 * INNER_CAP + 2];
+            BNode* child[2 * INNER_CAP + 2];
+            int n = ia->n + 1 + ib->n;
+            copy(ia->keys, ia->keys + ia->n, keys);
+            keys[ia->n] = in->keys[i];
+            copy(ib->keys, ib->keys + ib->n, keys + ia->n + 1);
+            copy(ia->counts, ia->counts + ia->n + 1, counts);
+            copy(ib->counts, ib->counts + ib->n + 1, counts + ia->n + 1);
+            copy(ia->child, ia->child + ia->n + 1, child);
+            copy(ib->child, ib->child + ib->n + 1, child + ia->n + 1);
+            merge = n <= INNER_CAP;
+            if (merge) {
+                fill(ia, keys, counts, child, 0, n);
+                delete ib;
+            } else {
+                int mid = n / 2;
+                fill(ia, keys, counts, child, 0, mid);
+                fill(ib, keys, counts, child, mid + 1, n);
+                in->keys[i] = keys[mid];
+                in->counts[i] = weight(ia, h);
+                in->counts[i + 1] = weight(ib, h);
+            }
+        }
+
+        if (merge) {
+            in->counts[i] += in->counts[i + 1];
+            copy(in->keys + i + 1, in->keys + in->n, in->keys + i);
+            copy(in->counts + i + 2, in->counts + in->n + 1, in->counts + i + 1);
+            copy(in->child + i + 2, in->child + in->n + 1, in->child + i + 1);
+            in->n--;
+        }
+    }
+
+    void destroy(BNode* x, int h) {
+        if (h > 0) {
+            Inner* in = static_cast<Inner*>(x);
+            for (int i = 0; i <= in->n; i++) destroy(in->child[i], h - 1);
+            delete in;
+        } else {
+            delete static_cast<Leaf*>(x);
+        }
+    }
+
+public:
+    BPlusTree() {
+        head = new Leaf;
+        head->n = 0;
+        head->next = nullptr;
+        root = head;
+    }
 
+    ~BPlusTree() { destroy(root, height); }
+
+    BPlusTree(const BPlusTree&) = delete;
+    BPlusTree& operator=(const BPlusTree&) = delete;
+
+    bool search(int key) const {
+        const Leaf* l = leafFor(key);
+        int i = countBelow(l->keys, l->n, key);
+        return i < l->n && l->keys[i] == key;
+    }
+
+    bool insert(int key) {
+        BNode* split;
+        int sep;
+        if (!insertRec(root, height, key, split, sep)) return false;
+        total++;
+        if (split) {
+            Inner* r = new Inner;
+            r->n = 1;
+            r->keys[0] = sep;
+            r->child[0] = root;
+            r->child[1] = split;
+            r->counts[1] = weight(split, height);
+            r->counts[0] = total - r->counts[1];
+            root = r;
+            height++;
+        }
+        return true;
+    }
+
+    bool remove(int key) {
+        if (!removeRec(root, height, key)) return false;
+        total--;
+        if (height > 0 && root->n == 0) {
+            Inner* old = static_cast<Inner*>(root);
+            root = old->child[0];
+            delete old;
+            height--;
+        }
         return true;
     }
 
-    int countLess(int key) {
+    // Every child left of the one search() takes lies wholly below key,
+    // so its count is added without visiting it.
+    int countLess(int key) const {
         int res = 0;
-        Node* cur = root;
-        while (cur != NIL) {
-            if (key <= cur->key)
-                cur = cur->left;
-            else {
-                res += cur->left->size + 1;
-                cur = cur->right;
+        const BNode* x = root;
+        for (int h = height; h > 0; h--) {
+            const Inner* in = static_cast<const Inner*>(x);
+            int c = countUpTo(in->keys, in->n, key);
+            for (int i = 0; i < c; i++) res += in->counts[i];
+            x = in->child[c];
+        }
+        const Leaf* l = static_cast<const Leaf*>(x);
+        return res + countBelow(l->keys, l->n, key);
+    }
+
+    int size() const { return total; }
+
+    // Replaces the contents with keys[0, n), which must be strictly
+    // increasing, in O(n). Keys are spread evenly over as few full-ish
+    // leaves as fit them, and each inner level likewise over its
+    // children, so every node meets its minimum fill.
+    void bulkLoad(const int* keys, size_t n) {
+        destroy(root, height);
+        vector<BNode*> level;
+        vector<int> lows, counts;               // first key and weight of each node
+        size_t leaves = max<size_t>(1, (n + LEAF_CAP - 1) / LEAF_CAP);
+        Leaf* prev = nullptr;
+        for (size_t i = 0, at = 0; i < leaves; i++) {
+            int take = (int)((n - at) / (leaves - i));
+            Leaf* l = new Leaf;
+            l->n = take;
+            l->next = nullptr;
+            copy(keys + at, keys + at + take, l->keys);
+            if (prev) prev->next = l;
+            else head = l;
+            prev = l;
+            level.push_back(l);
+            lows.push_back(take ? keys[at] : 0);
+            counts.push_back(take);
+            at += take;
+        }
+
+        height = 0;
+        while (level.size() > 1) {
+            size_t m = level.size();
+            size_t groups = (m + INNER_CAP) / (INNER_CAP + 1);
+            vector<BNode*> up;
+            vector<int> upLows, upCounts;
+            for (size_t g = 0, at = 0; g < groups; g++) {
+                int take = (int)((m - at) / (groups - g));
+                Inner* in = new Inner;
+                in->n = take - 1;
+                int w = 0;
+                for (int j = 0; j < take; j++) {
+                    in->child[j] = level[at + j];
+                    in->counts[j] = counts[at + j];
+                    if (j) in->keys[j - 1] = lows[at + j];
+                    w += counts[at + j];
+                }
+                up.push_back(in);
+                upLows.push_back(lows[at]);
+                upCounts.push_back(w);
+                at += take;
             }
+            level.swap(up);
+            lows.swap(upLows);
+            counts.swap(upCounts);
+            height++;
         }
-        return res;
+        root = level[0];
+        total = (int)n;
+    }
+
+    // calls f(key) for every key in increasing order
+    template <class F>
+    void forEach(F f) const {
+        for (const Leaf* l = head; l; l = l->next)
+            for (int i = 0; i < l->n; i++) f(l->keys[i]);
+    }
+
+    // calls f(key) for every key in [lo, hi), walking the leaf chain
+    template <class F>
+    void forRange(int lo, int hi, F f) const {
+        const Leaf* l = leafFor(lo);
+        for (int i = countBelow(l->keys, l->n, lo); l; l = l->next, i = 0) {
+            for (; i < l->n; i++) {
+                if (l->keys[i] >= hi) return;
+                f(l->keys[i]);
+            }
+        }
+    }
+
+    // read-only Eytzinger copy of the current keys, O(n)
+    FrozenSet freeze() const {
+        vector<int> sorted;
+        sorted.reserve(total);
+        for (const Leaf* l = head; l; l = l->next)
+            sorted.insert(sorted.end(), l->keys, l->keys + l->n);
+        return FrozenSet(sorted);
+    }
+};
+
+// Membership over the indices 0..n-1 of coordinate-compressed keys, for
+// the --batch mode below. A byte per index says whether it is present and
+// a Fenwick tree over the same indices answers countLess with one prefix
+// sum: two flat arrays, 5 bytes per distinct key, no pointers.
+class FenwickSet {
+private:
+    vector<char> present;
+    vector<int> sums;    // 1-based Fenwick sums of present
+
+    void add(int i, int d) {
+        for (i++; i < (int)sums.size(); i += i & -i) sums[i] += d;
+    }
+
+public:
+    explicit FenwickSet(int n) : present(n), sums(n + 1) {}
+
+    bool search(int i) const { return present[i]; }
+
+    bool insert(int i) {
+        if (present[i]) return false;
+        present[i] = 1;
+        add(i, 1);
+        return true;
+    }
+
+    bool remove(int i) {
+        if (!present[i]) return false;
+        present[i] = 0;
+        add(i, -1);
+        return true;
+    }
+
+    // number of present indices below i
+    int countLess(int i) const {
+        int s = 0;
+        for (; i > 0; i -= i & -i) s += sums[i];
+        return s;
     }
 };
 
-int main() {
-    ios::sync_with_stdio(false);
-    cin.tie(nullptr);
+// A run of search/countLess ops is answered from a frozen snapshot once it
+// is at least this long and at least 1/8 of the tree size, which pays for
+// the O(n) freeze.
+const int MIN_FROZEN_RUN = 1024;
+
+// With a store, the log is folded into a fresh snapshot once it holds
+// this many records, which bounds how much a restart has to replay.
+const size_t CHECKPOINT_RECORDS = 1 << 22;
+
+// Runs the op stream against Tree, which is RedBlackTree or BPlusTree.
+// A store, if given, supplies the starting set and logs every update
+// that takes effect.
+template <class Tree>
+void replay(const vector<pair<int, int>>& ops, OutBuf& out, SetStore* store) {
+    Tree tree;
+    if (store) store->recover(tree);
+    int N = (int)ops.size();
+
+    // end of the last read-only run found too short to freeze; runs are
+    // only measured from their first op, so the ops up to here run one
+    // by one
+    int runEnd = 0;
+
+    for (int i = 0; i < N; i++) {
+        int e = ops[i].first, x = ops[i].second;
+
+        if ((e == 2 || e == 3) && i >= runEnd) {
+            int j = i;
+            while (j < N && (ops[j].first == 2 || ops[j].first == 3)) j++;
+            if (j - i >= MIN_FROZEN_RUN && (j - i) * 8 >= tree.size()) {
+                FrozenSet frozen = tree.freeze();
+                for (; i < j; i++) {
+                    e = ops[i].first;
+                    x = ops[i].second;
+                    int r = (e == 2) ? frozen.contains(x) : frozen.countLess(x);
+                    out << e << " " << x << " " << r << '\n';
+                }
+                i = j - 1;
+                continue;
+            }
+            runEnd = j;
+        }
+
+        int r = 0;
+        if (e == 1) r = tree.insert(x);
+        else if (e == 0) r = tree.remove(x);
+        else if (e == 2) r = tree.search(x);
+        else if (e == 3) r = tree.countLess(x);
+
+        if (store && r && (e == 0 || e == 1)) {
+            store->append(e, x);
+            if (store->pending() >= CHECKPOINT_RECORDS) store->checkpoint(tree);
+        }
 
-    int N;
-    cin >> N;
-    cout << N << endl;
+        out << e << " " << x << " " << r << '\n';
+    }
+    if (store) store->sync();
+}
 
-    RedBlackTree rbt;
+// Every key the stream will ever touch is known up front, so each one is
+// replaced by its rank among the distinct keys and the ops run on a
+// FenwickSet. A key that is never inserted still gets a slot, which is
+// exactly what search and countLess need for it.
+void replayBatch(const vector<pair<int, int>>& ops, OutBuf& out) {
+    int N = (int)ops.size();
 
-    while (N--) {
-        int e, x;
-        cin >> e >> x;
+    // one sort of (key, op) pairs yields both the distinct keys and the
+    // rank of every op's key, without a binary search per op
+    vector<pair<int, int>> byKey(N);
+    for (int i = 0; i < N; i++) byKey[i] = {ops[i].second, i};
+    sort(byKey.begin(), byKey.end());
+
+    vector<int> rank(N);
+    int distinct = 0;
+    for (int i = 0; i < N; i++) {
+        if (i > 0 && byKey[i].first != byKey[i - 1].first) distinct++;
+        rank[byKey[i].second] = distinct;
+    }
+    vector<pair<int, int>>().swap(byKey);
+
+    FenwickSet set(N ? distinct + 1 : 0);
+    for (int i = 0; i < N; i++) {
+        int e = ops[i].first, x = ops[i].second, k = rank[i];
 
         int r = 0;
-        if (e == 1) r = rbt.insert(x);
-        else if (e == 0) r = rbt.remove(x);
-        else if (e == 2) r = rbt.search(x);
-        else if (e == 3) r = rbt.countLess(x);
+        if (e == 1) r = set.insert(k);
+        else if (e == 0) r = set.remove(k);
+        else if (e == 2) r = set.search(k);
+        else if (e == 3) r = set.countLess(k);
+
+        out << e << " " << x << " " << r << '\n';
+    }
+}
+
+// `RBToffline --btree` runs the same stream on the B+tree, `--batch` on
+// the offline Fenwick engine. `--store DIR` (tree engines only) starts
+// from the snapshot and log kept in DIR and logs the stream's updates
+// there. `--ops FILE` replays a binary op stream (see OpStream.h) instead
+// of reading text from stdin, and `--quiet` drops the output.
+int main(int argc, char* argv[]) {
+    string mode;
+    const char* storeDir = nullptr;
+    const char* opsPath = nullptr;
+    bool quiet = false;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--store" && i + 1 < argc) storeDir = argv[++i];
+        else if (arg == "--ops" && i + 1 < argc) opsPath = argv[++i];
+        else if (arg == "--quiet") quiet = true;
+        else if (arg == "--btree" || arg == "--batch") mode = arg;
+        else {
+            fprintf(stderr, "unknown argument %s\n"
+                    "usage: %s [--btree | --batch] [--store DIR] [--ops FILE] [--quiet]\n",
+                    argv[i], argv[0]);
+            return 1;
+        }
+    }
+    if (storeDir && mode == "--batch") {
+        fputs("--store needs a tree engine\n", stderr);
+        return 1;
+    }
+    OutBuf out;
+    if (quiet) out.mute();
+
+    vector<pair<int, int>> ops;
+    if (opsPath) {
+        try {
+            readOps(opsPath, ops);
+        } catch (const exception& e) {
+            fprintf(stderr, "%s\n", e.what());
+            return 1;
+        }
+    } else {
+        InBuf in;
+        int N;
+        in >> N;
+        if (N < 0) N = 0;
+        ops.resize(N);
+        for (auto& op : ops) in >> op.first >> op.second;
+    }
+    out << (int)ops.size() << '\n';
+
+    // store errors (unusable directory, damaged log or snapshot, failed
+    // writes) end the run; what was logged before them stays durable
+    try {
+        unique_ptr<SetStore> store;
+        if (storeDir) store.reset(new SetStore(storeDir));
 
-        cout << e << " " << x << " " << r << endl;
+        if (mode == "--btree") replay<BPlusTree>(ops, out, store.get());
+        else if (mode == "--batch") replayBatch(ops, out);
+        else replay<RedBlackTree<>>(ops, out, store.get());
+    } catch (const exception& e) {
+        fprintf(stderr, "%s\n", e.what());
+        return 1;
     }
+    out.flush();
+    TREE_STATS_DUMP(stderr);
     return 0;
 }
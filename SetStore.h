@@ -0,0 +1,226 @@
+#ifndef SET_STORE_H
+#define SET_STORE_H
+
+#include<cstdio>
+#include<cstddef>
+#include<cstdint>
+#include<cerrno>
+#include<cstring>
+#include<string>
+#include<stdexcept>
+
+#include<fcntl.h>
+#include<unistd.h>
+#include<sys/mman.h>
+#include<sys/stat.h>
+
+// Durable state of an int set kept in one directory:
+//
+//   wal       "SETWAL01", then 8-byte records {int32 op, int32 key}, one
+//             per applied update (op 1 insert, 0 remove, as in the op
+//             stream)
+//   snapshot  "SETSNAP1", uint64 key count, then the keys ascending as
+//             int32 -- laid out to be mmapped and read in place
+//
+// Each record sets a key's membership outright, so replaying a log on a
+// state that already contains some of it lands on the same set. That is
+// what makes checkpoint() safe without a sequence number: the new
+// snapshot is renamed into place first and only then is the log cut, and
+// a crash in between just replays records the snapshot already holds.
+//
+// Startup is recover(): bulk-build the tree from the mapped snapshot in
+// O(n), then replay whatever the log gained since. A torn record at the
+// end of the log (a crash mid-append) is dropped.
+//
+// Tree needs bulkLoad(const int*, size_t), insert, remove, size and
+// forEach; RedBlackTree and BPlusTree both qualify.
+class SetStore {
+private:
+    static constexpr char WAL_MAGIC[8] = {'S', 'E', 'T', 'W', 'A', 'L', '0', '1'};
+    static constexpr char SNAP_MAGIC[8] = {'S', 'E', 'T', 'S', 'N', 'A', 'P', '1'};
+
+    struct Record {
+        int32_t op;
+        int32_t key;
+    };
+
+    struct SnapHeader {
+        char magic[8];
+        uint64_t count;
+    };
+
+    std::string dir, walPath, snapPath;
+    FILE* wal = nullptr;
+    size_t records = 0;                         // in the log since the last snapshot
+
+    [[noreturn]] static void fail(const std::string& what, const std::string& path) {
+        throw std::runtime_error(what + " " + path + ": " + strerror(errno));
+    }
+
+    // fail() for a file that has to be closed on the way out; the close
+    // must not clobber the errno being reported
+    [[noreturn]] static void failClosing(int fd, const std::string& what, const std::string& path) {
+        int err = errno;
+        close(fd);
+        errno = err;
+        fail(what, path);
+    }
+
+    [[noreturn]] static void failClosing(FILE* f, const std::string& what, const std::string& path) {
+        int err = errno;
+        fclose(f);
+        errno = err;
+        fail(what, path);
+    }
+
+    static void syncFile(FILE* f, const std::string& path) {
+        if (fflush(f) != 0 || fsync(fileno(f)) != 0) fail("cannot sync", path);
+    }
+
+    // Opens the log for appending, creating it if needed, and trims a
+    // torn trailing record so new ones start on a record boundary.
+    void openWal() {
+        wal = fopen(walPath.c_str(), "r+b");
+        if (!wal) wal = fopen(walPath.c_str(), "w+b");
+        if (!wal) fail("cannot open", walPath);
+
+        struct stat st;
+        if (fstat(fileno(wal), &st) != 0) fail("cannot stat", walPath);
+        size_t len = st.st_size;
+        if (len < sizeof WAL_MAGIC) {
+            if (fwrite(WAL_MAGIC, sizeof WAL_MAGIC, 1, wal) != 1 || fflush(wal) != 0)
+                fail("cannot write", walPath);
+            len = sizeof WAL_MAGIC;
+        } else {
+            char magic[sizeof WAL_MAGIC];
+            if (fread(magic, sizeof magic, 1, wal) != 1 || memcmp(magic, WAL_MAGIC, sizeof magic) != 0)
+                throw std::runtime_error("not a set log: " + walPath);
+        }
+        records = (len - sizeof WAL_MAGIC) / sizeof(Record);
+        len = sizeof WAL_MAGIC + records * sizeof(Record);
+        if (ftruncate(fileno(wal), len) != 0) fail("cannot truncate", walPath);
+        fseek(wal, 0, SEEK_END);
+    }
+
+public:
+    explicit SetStore(const std::string& dir)
+        : dir(dir), walPath(dir + "/wal"), snapPath(dir + "/snapshot") {
+        if (mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST) fail("cannot create", dir);
+        try {
+            openWal();
+        } catch (...) {
+            // the destructor does not run for a constructor that throws
+            if (wal) fclose(wal);
+            throw;
+        }
+    }
+
+    ~SetStore() {
+        if (wal) {
+            fflush(wal);
+            fsync(fileno(wal));
+            fclose(wal);
+        }
+    }
+
+    SetStore(const SetStore&) = delete;
+    SetStore& operator=(const SetStore&) = delete;
+
+    // Rebuilds tree from the latest snapshot plus the log tail.
+    template <class Tree>
+    void recover(Tree& tree) {
+        int fd = open(snapPath.c_str(), O_RDONLY);
+        if (fd >= 0) {
+            struct stat st;
+            if (fstat(fd, &st) != 0) failClosing(fd, "cannot stat", snapPath);
+            size_t len = st.st_size;
+            void* base = len ? mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+            close(fd);
+            if (base == MAP_FAILED) fail("cannot map", snapPath);
+
+            const SnapHeader* h = static_cast<const SnapHeader*>(base);
+            if (len < sizeof *h || memcmp(h->magic, SNAP_MAGIC, sizeof SNAP_MAGIC) != 0
+                    || (len - sizeof *h) % sizeof(int32_t) != 0
+                    || h->count != (len - sizeof *h) / sizeof(int32_t)) {
+                munmap(base, len);
+                throw std::runtime_error("not a set snapshot: " + snapPath);
+            }
+            // the keys are read front to back, once to check them and once
+            // to build the tree
+            madvise(base, len, MADV_SEQUENTIAL);
+            const int32_t* keys = reinterpret_cast<const int32_t*>(h + 1);
+            for (size_t i = 1; i < h->count; i++) {
+                if (keys[i - 1] >= keys[i]) {
+                    munmap(base, len);
+                    throw std::runtime_error("snapshot keys not strictly ascending: " + snapPath);
+                }
+            }
+            tree.bulkLoad(keys, h->count);
+            munmap(base, len);
+        } else if (errno != ENOENT) {
+            fail("cannot open", snapPath);
+        }
+
+        FILE* f = fopen(walPath.c_str(), "rb");
+        if (!f) fail("cannot open", walPath);
+        fseek(f, sizeof WAL_MAGIC, SEEK_SET);
+        Record buf[4096];
+        size_t left = records, got;
+        while (left && (got = fread(buf, sizeof(Record), left < 4096 ? left : 4096, f)) > 0) {
+            for (size_t i = 0; i < got; i++) {
+                if (buf[i].op == 1) tree.insert(buf[i].key);
+                else tree.remove(buf[i].key);
+            }
+            left -= got;
+        }
+        fclose(f);
+    }
+
+    // Logs an applied update. Records sit in the stdio buffer until the
+    // next sync() or checkpoint(), so callers choose how much a crash
+    // may lose.
+    void append(int op, int key) {
+        Record r = {op, key};
+        if (fwrite(&r, sizeof r, 1, wal) != 1) fail("cannot write", walPath);
+        records++;
+    }
+
+    size_t pending() const { return records; }
+
+    void sync() { syncFile(wal, walPath); }
+
+    // Writes the whole set as a new snapshot and starts an empty log.
+    template <class Tree>
+    void checkpoint(const Tree& tree) {
+        std::string tmp = snapPath + ".tmp";
+        FILE* f = fopen(tmp.c_str(), "wb");
+        if (!f) fail("cannot create", tmp);
+        setvbuf(f, nullptr, _IOFBF, 1 << 20);
+
+        SnapHeader h;
+        memcpy(h.magic, SNAP_MAGIC, sizeof h.magic);
+        h.count = tree.size();
+        bool ok = fwrite(&h, sizeof h, 1, f) == 1;
+        tree.forEach([&](int key) {
+            int32_t k = key;
+            ok &= fwrite(&k, sizeof k, 1, f) == 1;
+        });
+        if (!ok) failClosing(f, "cannot write", tmp);
+        if (fflush(f) != 0 || fsync(fileno(f)) != 0) failClosing(f, "cannot sync", tmp);
+        fclose(f);
+        if (rename(tmp.c_str(), snapPath.c_str()) != 0) fail("cannot rename", tmp);
+        int fd = open(dir.c_str(), O_RDONLY);
+        if (fd < 0) fail("cannot open", dir);
+        if (fsync(fd) != 0) failClosing(fd, "cannot sync", dir);
+        close(fd);
+
+        // buffered records are in the snapshot too; flush them before the cut
+        if (fflush(wal) != 0) fail("cannot write", walPath);
+        if (ftruncate(fileno(wal), sizeof WAL_MAGIC) != 0) fail("cannot truncate", walPath);
+        fseek(wal, 0, SEEK_END);
+        records = 0;
+        sync();
+    }
+};
+
+#endif
@@ -0,0 +1,154 @@
+#ifndef TREE_STATS_H
+#define TREE_STATS_H
+
+// Opt-in hot-path counters for the balanced trees, for telling why one
+// op stream runs slower than another: fixup loop trips, rotations and
+// rebalance cases, AVL height changes, and the lengths of lookup paths
+// as a depth histogram.
+//
+// Build with -DTREE_STATS to turn them on. Without it TREE_STAT() and
+// TREE_STATS_DUMP() expand to nothing and TreePath is an empty object,
+// so release builds carry no trace of them.
+//
+// Each thread counts into its own TreeStats; only the owner writes, so
+// an increment is a plain load and store. A thread's counts are folded
+// into a shared total when it exits, and TreeStats::dump() adds up the
+// total and every live thread and prints them as one JSON object.
+
+#ifdef TREE_STATS
+
+#include<atomic>
+#include<cstdio>
+#include<cstdint>
+#include<mutex>
+#include<vector>
+#include<algorithm>
+
+class TreeStats {
+public:
+    enum Counter {
+        RB_INSERT_FIX_LOOPS,
+        RB_DELETE_FIX_LOOPS,
+        RB_LEFT_ROTATIONS,
+        RB_RIGHT_ROTATIONS,
+        AVL_LL,                 // rebalance cases, named by the heavy path
+        AVL_LR,
+        AVL_RR,
+        AVL_RL,
+        AVL_HEIGHT_CHANGES,     // levels retrace() climbed with a changed height
+        LOOKUPS,
+        LOOKUP_STEPS,           // nodes visited over all lookups
+        COUNTERS
+    };
+    static const int DEPTHS = 64;              // the last bucket takes anything deeper
+
+    static TreeStats& local() {
+        thread_local TreeStats s;
+        return s;
+    }
+
+    void bump(Counter c) { add(counts[c], 1); }
+
+    // one lookup that visited len nodes
+    void path(int len) {
+        add(counts[LOOKUPS], 1);
+        add(counts[LOOKUP_STEPS], len);
+        add(depth[std::min(len, DEPTHS - 1)], 1);
+    }
+
+    static void dump(FILE* f) {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> g(r.m);
+        uint64_t c[COUNTERS], d[DEPTHS];
+        std::copy(r.retired, r.retired + COUNTERS, c);
+        std::copy(r.retiredDepth, r.retiredDepth + DEPTHS, d);
+        for (TreeStats* s : r.live) s->addTo(c, d);
+
+        static const char* const names[COUNTERS] = {
+            "rb_insert_fix_loops", "rb_delete_fix_loops",
+            "rb_left_rotations", "rb_right_rotations",
+            "avl_ll", "avl_lr", "avl_rr", "avl_rl", "avl_height_changes",
+            "lookups", "lookup_steps",
+        };
+        fprintf(f, "{\"threads\": %zu", r.live.size() + r.exited);
+        for (int i = 0; i < COUNTERS; i++)
+            fprintf(f, ", \"%s\": %llu", names[i], (unsigned long long)c[i]);
+        int last = DEPTHS;
+        while (last > 0 && d[last - 1] == 0) last--;
+        fprintf(f, ", \"lookup_depths\": [");
+        for (int i = 0; i < last; i++)
+            fprintf(f, "%s%llu", i ? ", " : "", (unsigned long long)d[i]);
+        fprintf(f, "]}\n");
+    }
+
+private:
+    std::atomic<uint64_t> counts[COUNTERS];
+    std::atomic<uint64_t> depth[DEPTHS];
+
+    struct Registry {
+        std::mutex m;
+        std::vector<TreeStats*> live;
+        uint64_t retired[COUNTERS] = {};
+        uint64_t retiredDepth[DEPTHS] = {};
+        size_t exited = 0;
+    };
+
+    static Registry& registry() {
+        static Registry r;
+        return r;
+    }
+
+    // only the owning thread writes, so no read-modify-write is needed;
+    // the atomics just make dump()'s reads from other threads well defined
+    static void add(std::atomic<uint64_t>& c, uint64_t d) {
+        c.store(c.load(std::memory_order_relaxed) + d, std::memory_order_relaxed);
+    }
+
+    void addTo(uint64_t* c, uint64_t* d) const {
+        for (int i = 0; i < COUNTERS; i++) c[i] += counts[i].load(std::memory_order_relaxed);
+        for (int i = 0; i < DEPTHS; i++) d[i] += depth[i].load(std::memory_order_relaxed);
+    }
+
+    TreeStats() {
+        for (auto& c : counts) c.store(0, std::memory_order_relaxed);
+        for (auto& c : depth) c.store(0, std::memory_order_relaxed);
+        Registry& r = registry();
+        std::lock_guard<std::mutex> g(r.m);
+        r.live.push_back(this);
+    }
+
+    ~TreeStats() {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> g(r.m);
+        addTo(r.retired, r.retiredDepth);
+        r.live.erase(std::find(r.live.begin(), r.live.end(), this));
+        r.exited++;
+    }
+};
+
+// Counts the nodes one lookup visits: step() per node, recorded when the
+// probe goes out of scope.
+class TreePath {
+private:
+    int n = 0;
+
+public:
+    void step() { n++; }
+    ~TreePath() { TreeStats::local().path(n); }
+};
+
+#define TREE_STAT(c) TreeStats::local().bump(TreeStats::c)
+#define TREE_STATS_DUMP(f) TreeStats::dump(f)
+
+#else
+
+struct TreePath {
+    void step() {}
+};
+
+#define TREE_STAT(c) ((void)0)
+#define TREE_STATS_DUMP(f) ((void)0)
+
+#endif
+
+#endif